@@ -23,8 +23,10 @@
 #include "mouseControl.h"
 #include "keys.h"
 #include "buttons.h"
+#include "pressureSensor.h"
 #include "display.h"
 #include "NeoPixel.h"
+#include "diagnostics.h"
 
 #include <Wire.h>
 #include <SPI.h>
@@ -38,6 +40,7 @@ int8_t  led_map[NUMBER_OF_LEDS] = {14, 15, 16};
 const struct settingsType defaultSettings = {      // type definition see fabi.h
   "slot1", DEFAULT_WHEEL_STEPSIZE, DEFAULT_TRESHOLD_TIME,
   DEFAULT_SIP_THRESHOLD, DEFAULT_PUFF_THRESHOLD,
+  DEFAULT_STRONG_SIP_THRESHOLD, DEFAULT_STRONG_PUFF_THRESHOLD, DEFAULT_SIP_PUFF_HYSTERESIS,
   DEFAULT_ANTITREMOR_PRESS, DEFAULT_ANTITREMOR_RELEASE, DEFAULT_ANTITREMOR_IDLE,
   DEFAULT_BT_MODE, DEFAULT_DOUBLEPRESS_TIME, DEFAULT_AUTODWELL_TIME, 0xFFFFFF
 };
@@ -65,7 +68,7 @@ int freeRam();
 void setup() {
   //load settings
   memcpy(&settings,&defaultSettings,sizeof(struct settingsType));
-  Serial.begin(9600);    // open serial port for AT commands / GUI communication
+  hostSerial.begin(9600);    // open serial port for AT commands / GUI communication
   Serial1.begin(9600);   // open the serial port for BT-Module 
   delay(1000);           // allow some time for the BT-Module to start ...
   
@@ -79,7 +82,7 @@ void setup() {
   if (!digitalRead(PCB_checkPin)) {            //PCB Version detected
     PCBversion = 1;
     #ifdef DEBUG_OUTPUT
-        Serial.println("FABI PCB Version");
+        hostSerial.println("FABI PCB Version");
     #endif
 
     // turn off built-in LEDs
@@ -103,6 +106,10 @@ void setup() {
   // initialise button pins and debouncers
   initButtons();
 
+  // start free running sampling of the sip/puff sensor
+  initPressureSensor();
+  calibratePressure();
+
   // read button modes from first EEPROM slot (if available)
   bootstrapEEPROM();
   readFromEEPROM(0);
@@ -122,8 +129,8 @@ void setup() {
   }
 
   #ifdef DEBUG_OUTPUT
-    Serial.println("Flexible Assistive Button Interface started !");
-    Serial.print(F("Free RAM:"));  Serial.println(freeRam());
+    hostSerial.println("Flexible Assistive Button Interface started !");
+    hostSerial.print(F("Free RAM:"));  hostSerial.println(freeRam());
   #endif
 }
 
@@ -137,6 +144,9 @@ void setup() {
 */
 void loop() {
 
+  // send queued output to the host, as far as possible without waiting
+  hostSerial.update();
+
   //check if we should go into addon upgrade mode
 	if(addonUpgrade != BTMODULE_UPGRADE_IDLE) {
     performAddonUpgrade();
@@ -144,28 +154,44 @@ void loop() {
 	}
 
   // get and parse incoming bytes for Serial
-  while (Serial.available() > 0) {
-    int inByte = Serial.read();
+  while (hostSerial.available() > 0) {
+    int inByte = hostSerial.read();
     parseByte (inByte);      // implemented in parser.cpp
   }
 
   // if incoming data from BT-addOn: forward it to host serial interface
-  while (Serial1.available() > 0) {
-    Serial.write(Serial1.read());
+  // (as long as the transmit queue has space, the rest waits in the Serial1 buffer)
+  while ((Serial1.available() > 0) && (hostSerial.availableForWrite() > 0)) {
+    hostSerial.write(Serial1.read());
   }
+  profileStage(PROFILE_SERIAL);
   
+  // handle switch edges which were captured by the pin change interrupts
+  handleButtonEvents();
+  profileStage(PROFILE_EVENTS);
+
   // update button states and perform periodic mouse updates
   if (millis() - updateTimestamp >= waitTime) {
     
+    profileTick();
     updateTimestamp = millis();
     updateButtons();
+    profileStage(PROFILE_BUTTONS);
+    updateMacro();
+    profileStage(PROFILE_MACRO);
     updateMouse();
+    profileStage(PROFILE_MOUSE);
 
     if (PCBversion) {
       //UpdateBuzzer();       // generate tones (indicating slot change)
       UpdateNeoPixel();     // update the brightness of the NeoPixel if slotchange occured
     }
     else UpdateLeds();      // update slot indication leds in case no PCB version
+    profileStage(PROFILE_LEDS);
+
+    // decode the next slot in advance (once after a slot change), while most of the wait time is left
+    prefetchNextSlot();
+    profileStage(PROFILE_PREFETCH);
   }
 }
 
@@ -198,5 +224,5 @@ int freeRam ()
 {
   extern int __heap_start, *__brkval;
   int v;
-  return (int) &v - (__brkval == 0 ? (int) &__heap_start : (int) __brkval);
+  return (int) ((uintptr_t) &v - (__brkval == 0 ? (uintptr_t) &__heap_start : (uintptr_t) __brkval));
 }
@@ -0,0 +1,293 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: binaryProtocol.cpp - binary framed configuration protocol
+     (for the frame format and opcodes see binaryProtocol.h)
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include <stddef.h>
+#include <util/crc16.h>
+#include "fabi.h"
+#include "eepromStorage.h"
+#include "keys.h"
+#include "binaryProtocol.h"
+
+#define FRAMESTATE_IDLE    0
+#define FRAMESTATE_LENGTH  1
+#define FRAMESTATE_OPCODE  2
+#define FRAMESTATE_PAYLOAD 3
+#define FRAMESTATE_CRC_LOW 4
+#define FRAMESTATE_CRC_HIGH 5
+
+#define SETTING_FIELD(c, f) { c, offsetof(struct settingsType, f), sizeof(settingsType::f) }
+
+const struct settingFieldType settingFields[] PROGMEM = {
+  SETTING_FIELD(CMD_WS, ws), SETTING_FIELD(CMD_TT, tt), SETTING_FIELD(CMD_TS, ts), SETTING_FIELD(CMD_TP, tp),
+  SETTING_FIELD(CMD_SS, ss), SETTING_FIELD(CMD_SP, sp), SETTING_FIELD(CMD_SH, sh), SETTING_FIELD(CMD_AP, ap),
+  SETTING_FIELD(CMD_AR, ar), SETTING_FIELD(CMD_AI, ai), SETTING_FIELD(CMD_BT, bt), SETTING_FIELD(CMD_DP, dp),
+  SETTING_FIELD(CMD_AD, ad), SETTING_FIELD(CMD_SC, sc)
+};
+static_assert(sizeof(settingFields) / sizeof(struct settingFieldType) == NUM_SETTING_FIELDS, "NUM_SETTING_FIELDS does not match settingFields[]");
+
+uint8_t frameState = FRAMESTATE_IDLE;
+uint8_t frameLength = 0;            // payload length of the current frame
+uint8_t frameOpcode = 0;
+uint8_t framePos = 0;               // number of payload bytes received
+uint16_t frameCrc = 0;              // crc of the received bytes
+uint16_t frameReceivedCrc = 0;
+uint32_t frameTimestamp = 0;        // millis() of the last received frame byte
+uint8_t frameCount = 0;             // frames applied since the last FRAME_SAVE_SLOT (see saveSlotFrame())
+
+/**
+   @name sendFrame
+   @param uint8_t opcode  the opcode of the frame
+   @param const uint8_t * payload  the payload bytes
+   @param uint8_t length  number of payload bytes
+   @return none
+
+   sends a frame to the host (hostSerial)
+*/
+void sendFrame(uint8_t opcode, const uint8_t * payload, uint8_t length)
+{
+  uint16_t crc = 0xffff;
+  crc = _crc_ccitt_update(crc, length);
+  crc = _crc_ccitt_update(crc, opcode);
+  for (uint8_t i = 0; i < length; i++)
+    crc = _crc_ccitt_update(crc, payload[i]);
+
+  hostSerial.write(FRAME_MAGIC);
+  hostSerial.write(length);
+  hostSerial.write(opcode);
+  hostSerial.write(payload, length);
+  hostSerial.write(crc & 0xff);
+  hostSerial.write(crc >> 8);
+}
+
+/**
+   @name sendReply
+   @param uint8_t error  0 for FRAME_ACK, else the error code for FRAME_NAK
+   @return none
+
+   acknowledges or rejects the current frame
+*/
+void sendReply(uint8_t error)
+{
+  uint8_t reply[2] = {frameOpcode, error};
+  if (error) sendFrame(FRAME_NAK, reply, 2);
+  else sendFrame(FRAME_ACK, reply, 1);
+}
+
+/**
+   @name findSettingField
+   @param uint8_t cmd  the AT command of the setting
+   @return int8_t  index into settingFields[], -1 if the command does not change a setting
+*/
+int8_t findSettingField(uint8_t cmd)
+{
+  for (uint8_t i = 0; i < NUM_SETTING_FIELDS; i++)
+    if (pgm_read_byte_near(&settingFields[i].cmd) == cmd) return (i);
+  return (-1);
+}
+
+/**
+   @name setButtonFrame
+   @param uint8_t * payload  button, command identifier, value, string parameter
+   @param uint8_t length  payload length
+   @return uint8_t  0 or error code
+
+   stores a new function for a button (like AT BM followed by an AT command)
+*/
+uint8_t setButtonFrame(uint8_t * payload, uint8_t length)
+{
+  if (length < 5) return (FRAME_ERR_LENGTH);
+  uint8_t button = payload[0];
+  int8_t cmd = lookupCommand(charUp(payload[1]), charUp(payload[2]));
+  if ((button < 1) || (button > NUMBER_OF_BUTTONS) || (cmd < 0)) return (FRAME_ERR_PARAMETER);
+
+  char * parString = (char *)payload + 5;
+  payload[length] = 0;
+  setKeystring(button - 1, parString);
+  if (strcmp(getKeystring(button - 1), parString)) return (FRAME_ERR_MEMORY);
+
+  buttons[button - 1].mode = cmd;
+  buttons[button - 1].value = (int16_t)(payload[3] | (payload[4] << 8));
+  compileKeyActions();
+  return (0);
+}
+
+/**
+   @name setSettingFrame
+   @param uint8_t * payload  command identifier, value
+   @param uint8_t length  payload length
+   @return uint8_t  0 or error code
+
+   changes a setting of the current slot (like AT TS, AT WS, ...)
+*/
+uint8_t setSettingFrame(uint8_t * payload, uint8_t length)
+{
+  if (length != 6) return (FRAME_ERR_LENGTH);
+  int8_t cmd = lookupCommand(charUp(payload[0]), charUp(payload[1]));
+  int8_t field = (cmd < 0) ? -1 : findSettingField(cmd);
+  if (field < 0) return (FRAME_ERR_PARAMETER);
+
+  // note: settings and payload are little endian, copy the lower bytes
+  memcpy((uint8_t *)&settings + pgm_read_byte_near(&settingFields[field].offset), payload + 2,
+         pgm_read_byte_near(&settingFields[field].size));
+  return (0);
+}
+
+/**
+   @name saveSlotFrame
+   @param uint8_t * payload  frame count, slot name
+   @param uint8_t length  payload length
+   @return uint8_t  0 or error code
+
+   saves the current configuration (like AT SA), but only if all frames which the host sent
+   since the last save were applied: a frame which was rejected or lost (e.g. a corrupted
+   FRAME_MAGIC) would leave an incomplete slot
+*/
+uint8_t saveSlotFrame(uint8_t * payload, uint8_t length)
+{
+  uint8_t count = frameCount;
+  frameCount = 0;
+  if ((length < 2) || (length > MAX_SLOTNAME_LEN)) return (FRAME_ERR_LENGTH);
+  if (payload[0] != count) return (FRAME_ERR_REJECTED);
+
+  payload[length] = 0;
+  release_all();
+  if (!saveToEEPROM((char *)payload + 1)) return (FRAME_ERR_MEMORY);
+  return (0);
+}
+
+/**
+   @name readSlotFrame
+   @param uint8_t * payload  slot name (optional)
+   @param uint8_t length  payload length
+   @return uint8_t  0 or error code
+
+   loads the given slot (if a name is given) and sends the configuration
+   as frames which can be used to upload the slot again.
+   nothing is sent if a keystring does not fit into a FRAME_SET_BUTTON frame.
+*/
+uint8_t readSlotFrame(uint8_t * payload, uint8_t length)
+{
+  uint8_t data[FRAME_MAX_PAYLOAD];
+
+  if (length) {
+    payload[length] = 0;
+    if (!loadSlot((char *)payload)) return (FRAME_ERR_NOT_FOUND);
+    frameCount = 0;                   // the loaded slot replaces the uploaded frames
+  }
+  for (uint8_t i = 0; i < NUMBER_OF_BUTTONS; i++)
+    if (strlen(getKeystring(i)) > FRAME_MAX_PAYLOAD - 5) return (FRAME_ERR_LENGTH);
+
+  for (uint8_t i = 0; i < NUM_SETTING_FIELDS; i++) {
+    uint8_t cmd = pgm_read_byte_near(&settingFields[i].cmd);
+    uint32_t value = 0;
+    memcpy(&value, (uint8_t *)&settings + pgm_read_byte_near(&settingFields[i].offset),
+           pgm_read_byte_near(&settingFields[i].size));
+    data[0] = pgm_read_byte_near(&atCommands[cmd].atCmd[0]);
+    data[1] = pgm_read_byte_near(&atCommands[cmd].atCmd[1]);
+    memcpy(data + 2, &value, 4);
+    sendFrame(FRAME_SET_SETTING, data, 6);
+  }
+
+  for (uint8_t i = 0; i < NUMBER_OF_BUTTONS; i++) {
+    uint8_t len = strlen(getKeystring(i));
+    data[0] = i + 1;
+    data[1] = pgm_read_byte_near(&atCommands[buttons[i].mode].atCmd[0]);
+    data[2] = pgm_read_byte_near(&atCommands[buttons[i].mode].atCmd[1]);
+    data[3] = buttons[i].value & 0xff;
+    data[4] = buttons[i].value >> 8;
+    memcpy(data + 5, getKeystring(i), len);
+    sendFrame(FRAME_SET_BUTTON, data, len + 5);
+  }
+
+  data[0] = NUM_SETTING_FIELDS + NUMBER_OF_BUTTONS;
+  strcpy((char *)data + 1, settings.slotname);
+  sendFrame(FRAME_SAVE_SLOT, data, strlen(settings.slotname) + 1);
+  return (0);
+}
+
+/**
+   @name performFrame
+   @param none
+   @return none
+
+   executes a received frame (payload is in cmdstring[]) and sends the reply
+*/
+void performFrame()
+{
+  uint8_t * payload = (uint8_t *)cmdstring;
+  uint8_t error;
+
+  switch (frameOpcode) {
+    case FRAME_SET_BUTTON:  error = setButtonFrame(payload, frameLength); break;
+    case FRAME_SET_SETTING: error = setSettingFrame(payload, frameLength); break;
+    case FRAME_SAVE_SLOT:   error = saveSlotFrame(payload, frameLength); break;
+    case FRAME_READ_SLOT:   error = readSlotFrame(payload, frameLength); break;
+    default:                error = FRAME_ERR_OPCODE; break;
+  }
+  if ((!error) && ((frameOpcode == FRAME_SET_BUTTON) || (frameOpcode == FRAME_SET_SETTING)))
+    frameCount++;
+  sendReply(error);
+}
+
+/**
+   @name parseFrameByte
+   @param uint8_t newByte  the received byte
+   @return uint8_t  1 if the byte belongs to a binary frame, 0 if it should be handled by the AT command parser
+
+   receives binary frames byte by byte: a frame starts with FRAME_MAGIC,
+   its payload is stored into cmdstring[] (so AT commands and frames cannot be mixed)
+*/
+uint8_t parseFrameByte(uint8_t newByte)
+{
+  if ((frameState != FRAMESTATE_IDLE) && (millis() - frameTimestamp > FRAME_TIMEOUT))
+    frameState = FRAMESTATE_IDLE;     // discard incomplete frame
+  frameTimestamp = millis();
+
+  switch (frameState) {
+    case FRAMESTATE_IDLE:
+      if (newByte != FRAME_MAGIC) return (0);
+      frameCrc = 0xffff;
+      frameState = FRAMESTATE_LENGTH;
+      break;
+    case FRAMESTATE_LENGTH:
+      frameLength = newByte;
+      framePos = 0;
+      frameCrc = _crc_ccitt_update(frameCrc, newByte);
+      frameState = FRAMESTATE_OPCODE;
+      break;
+    case FRAMESTATE_OPCODE:
+      frameOpcode = newByte;
+      frameCrc = _crc_ccitt_update(frameCrc, newByte);
+      frameState = frameLength ? FRAMESTATE_PAYLOAD : FRAMESTATE_CRC_LOW;
+      break;
+    case FRAMESTATE_PAYLOAD:
+      if (framePos < FRAME_MAX_PAYLOAD) cmdstring[framePos] = newByte;   // longer frames are skipped
+      framePos++;
+      frameCrc = _crc_ccitt_update(frameCrc, newByte);
+      if (framePos == frameLength) frameState = FRAMESTATE_CRC_LOW;
+      break;
+    case FRAMESTATE_CRC_LOW:
+      frameReceivedCrc = newByte;
+      frameState = FRAMESTATE_CRC_HIGH;
+      break;
+    case FRAMESTATE_CRC_HIGH:
+      frameReceivedCrc |= (uint16_t)newByte << 8;
+      frameState = FRAMESTATE_IDLE;
+      if (frameReceivedCrc != frameCrc) sendReply(FRAME_ERR_CRC);
+      else if (frameLength > FRAME_MAX_PAYLOAD) sendReply(FRAME_ERR_LENGTH);
+      else performFrame();
+      break;
+  }
+  return (1);
+}
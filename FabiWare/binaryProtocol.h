@@ -0,0 +1,64 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: binaryProtocol.h - binary framed configuration protocol
+
+     Frame format (host -> FABI and FABI -> host):
+       FRAME_MAGIC, length, opcode, payload (length bytes), crc low, crc high
+       the crc is CRC-16/MCRF4XX over length, opcode and payload (_crc_ccitt_update() of avr-libc):
+       polynomial 0x1021 reflected (0x8408), start value 0xffff, reflected input and output,
+       no final xor; check value of "123456789": 0x6F91
+
+     Opcodes and payloads (multi-byte values are little endian):
+       FRAME_SET_BUTTON   button (1-13), command identifier (2 chars), value (int16), string parameter (rest of payload)
+       FRAME_SET_SETTING  command identifier of the setting (2 chars, e.g. "TS"), value (uint32)
+       FRAME_SAVE_SLOT    frame count (uint8), slot name: saves the configuration. The frame count is the
+                          number of FRAME_SET_BUTTON and FRAME_SET_SETTING frames sent since the
+                          previous FRAME_SAVE_SLOT (modulo 256), the save fails (FRAME_ERR_REJECTED)
+                          if a different number of them was applied (a frame was rejected or lost)
+       FRAME_READ_SLOT    slot name (optional): loads the slot and replies its configuration as
+                          FRAME_SET_SETTING, FRAME_SET_BUTTON and FRAME_SAVE_SLOT frames
+                          (FRAME_ERR_LENGTH if a keystring is longer than FRAME_MAX_PAYLOAD - 5)
+
+     every frame is answered with FRAME_ACK (payload: opcode) or FRAME_NAK (payload: opcode, error code).
+     FRAME_TELEMETRY and FRAME_BURST are sent by FABI only (live values, see telemetry.h).
+     Frames can be sent without waiting for the replies, so a complete slot is uploaded in one round trip.
+     An incomplete frame is discarded after FRAME_TIMEOUT milliseconds.
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+
+#ifndef _BINARYPROTOCOL_H_
+#define _BINARYPROTOCOL_H_
+
+#define FRAME_MAGIC          0xFB     // start of a binary frame (cannot be the start of an AT command)
+#define FRAME_MAX_PAYLOAD    (MAX_CMDLEN - 2)   // frames are received into cmdstring[]
+#define FRAME_TIMEOUT        100      // maximum time between two bytes of a frame (milliseconds)
+
+#define FRAME_SET_BUTTON     0x01
+#define FRAME_SET_SETTING    0x02
+#define FRAME_SAVE_SLOT      0x03
+#define FRAME_READ_SLOT      0x04
+#define FRAME_ACK            0x80
+#define FRAME_NAK            0x81
+#define FRAME_TELEMETRY      0x90
+#define FRAME_BURST          0x91
+
+#define FRAME_ERR_CRC        1        // crc mismatch
+#define FRAME_ERR_LENGTH     2        // payload too long or too short
+#define FRAME_ERR_OPCODE     3        // unknown opcode
+#define FRAME_ERR_PARAMETER  4        // unknown button, command or setting
+#define FRAME_ERR_MEMORY     5        // keystring buffer or EEPROM full
+#define FRAME_ERR_NOT_FOUND  6        // slot not found
+#define FRAME_ERR_REJECTED   7        // save refused: the frame count differs (a previous frame was rejected or lost)
+
+uint8_t parseFrameByte(uint8_t newByte);
+void sendFrame(uint8_t opcode, const uint8_t * payload, uint8_t length);
+
+#endif
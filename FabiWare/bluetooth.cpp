@@ -26,8 +26,6 @@ uint8_t readstate_f=0;              // needed to track the return value status d
 long btsendTimestamp = millis();    // to limit BT bandwidth
 long upgradeTimestamp = 0;          // eventually come back to AT mode from an unsuccessful BT module upgrade !
 
-#define Serial_AUX Serial1
-
 //#define DEBUG_OUTPUT_FULL
 
 /**
@@ -49,15 +47,15 @@ void mouseBT(int x, int y, uint8_t scroll)
   static int accuX = 0, accuY = 0;
 
 #ifdef DEBUG_OUTPUT_FULL
-  Serial.println("BT mouse actions:");
-  Serial.print("buttons: 0x");
-  Serial.println(activeMouseButtons, HEX);
-  Serial.print("x/y/scroll: ");
-  Serial.print(x, DEC);
-  Serial.print("/");
-  Serial.print(y, DEC);
-  Serial.print("/");
-  Serial.println(scroll, DEC);
+  hostSerial.println("BT mouse actions:");
+  hostSerial.print("buttons: 0x");
+  hostSerial.println(activeMouseButtons, HEX);
+  hostSerial.print("x/y/scroll: ");
+  hostSerial.print(x, DEC);
+  hostSerial.print("/");
+  hostSerial.print(y, DEC);
+  hostSerial.print("/");
+  hostSerial.println(scroll, DEC);
 #endif
 
   accuX += x;
@@ -154,16 +152,16 @@ boolean isMouseBTPressed(uint8_t mousebutton)
 void sendBTKeyboardReport()
 {
 #ifdef DEBUG_OUTPUT_FULL
-  Serial.println("BT keyboard actions:");
-  Serial.print("modifier: 0x");
-  Serial.println(activeModifierKeys, HEX);
-  Serial.println("activeKeyCodes: ");
-  Serial.println(activeKeyCodes[0], HEX);
-  Serial.println(activeKeyCodes[1], HEX);
-  Serial.println(activeKeyCodes[2], HEX);
-  Serial.println(activeKeyCodes[3], HEX);
-  Serial.println(activeKeyCodes[4], HEX);
-  Serial.println(activeKeyCodes[5], HEX);
+  hostSerial.println("BT keyboard actions:");
+  hostSerial.print("modifier: 0x");
+  hostSerial.println(activeModifierKeys, HEX);
+  hostSerial.println("activeKeyCodes: ");
+  hostSerial.println(activeKeyCodes[0], HEX);
+  hostSerial.println(activeKeyCodes[1], HEX);
+  hostSerial.println(activeKeyCodes[2], HEX);
+  hostSerial.println(activeKeyCodes[3], HEX);
+  hostSerial.println(activeKeyCodes[4], HEX);
+  hostSerial.println(activeKeyCodes[5], HEX);
 #endif
 
   Serial_AUX.write(0xFD);       			//raw HID
@@ -201,7 +199,7 @@ void keyboardBTPress(int key)
 		key = pgm_read_byte(_asciimap + key);
 		if (!key) {
 			
-			return 0;
+			return;
 		}
 		//Serial.print("key:");
 		//Serial.println(key,HEX);
@@ -247,7 +245,7 @@ void keyboardBTRelease(int key)
 	} else {				// it's a printing key
 		key = pgm_read_byte(_asciimap + key);
 		if (!key) {
-			return 0;
+			return;
 		}
 		if (key & 0x80) {							// it's a capital letter or other character reached with shift
 			activeModifierKeys &= ~(0x02);	// the left shift modifier
@@ -305,7 +303,7 @@ void initBluetooth()
   char c,count=0;
 
 #ifdef DEBUG_OUTPUT_FULL
-  Serial.println("init Bluetooth");
+  hostSerial.println("init Bluetooth");
 #endif
 
   // empty serial1 buffer
@@ -325,8 +323,8 @@ void initBluetooth()
   } while ((millis()-timestamp < BT_IDRESPONSE_TIMEOUT) && (count<sizeof(id)-1) && (c!='\n'));
   
 #ifdef DEBUG_OUTPUT_FULL
-  Serial.print ("BT answer = ");
-  Serial.println (id);
+  hostSerial.print ("BT answer = ");
+  hostSerial.println (id);
 #endif
 
   if (!strncmp(id,"ESP32miniBT",11)) {
@@ -383,10 +381,10 @@ void performAddonUpgrade()
     Serial1.end();
     pinMode(0,INPUT);
     Serial1.begin(500000); //switch to higher speed...
-    Serial.flush();
+    hostSerial.flush();
     Serial1.flush();
     //remove everything from buffers...
-    while(Serial.available()) Serial.read();
+    while(hostSerial.available()) hostSerial.read();
     while(Serial1.available()) Serial1.read();
     addonUpgrade = BTMODULE_UPGRADE_RUNNING;
     upgradeTimestamp=millis();
@@ -395,22 +393,22 @@ void performAddonUpgrade()
 
   if(addonUpgrade == BTMODULE_UPGRADE_RUNNING)
   {
-    if(Serial.available()) upgradeTimestamp=millis();   // incoming data: assume working upgrade!
+    if(hostSerial.available()) upgradeTimestamp=millis();   // incoming data: assume working upgrade!
     else {
       // 20 seconds no data -> return to AT mode !
       if (millis()-upgradeTimestamp > 20000) {
         addonUpgrade = BTMODULE_UPGRADE_IDLE;
         Serial1.begin(9600); //switch to lower speed...
-        Serial.flush();
+        hostSerial.flush();
         Serial1.flush();
         return;
       }
     }
         
-    while(Serial.available()) Serial1.write(Serial.read());
+    while(hostSerial.available()) Serial1.write(hostSerial.read());
     while(Serial1.available()) {
       int inByte = Serial1.read();
-      Serial.write(inByte);
+      hostSerial.write(inByte);
       switch (readstate_f) {
         case 0:
             if (inByte=='$') readstate_f++;
@@ -428,7 +426,7 @@ void performAddonUpgrade()
             readstate_f=0;
             delay(50);
             Serial1.begin(9600); //switch to lower speed...
-            Serial.flush();
+            hostSerial.flush();
             Serial1.flush();
             } else readstate_f=0;
           break;
@@ -26,8 +26,8 @@ extern const uint8_t _asciimap[128] PROGMEM;
 #define BTMODULE_UPGRADE_RUNNING 2
 
 
-//RX/TX3 are used to communicate with an addon board (mounted on AUX header)
-#define Serial_AUX Serial3
+//RX/TX1 are used to communicate with an addon board (mounted on AUX header)
+#define Serial_AUX Serial1
 
 /**
 
@@ -15,21 +15,207 @@
 #include "fabi.h"
 #include "keys.h"
 #include "buttons.h"
+#include "diagnostics.h"
+#include "pressureSensor.h"
+#include "telemetry.h"
 
-int8_t  input_map[NUMBER_OF_PHYSICAL_BUTTONS_NOPCB] = {2, 3, 4, 5, 6, 7, 8, 9, 10};
-int8_t  input_map_PCB[NUMBER_OF_PHYSICAL_BUTTONS_PCB] = {10, 16, 19, 5, 6, 7, 8, 9};
+int8_t  input_map[NUMBER_OF_PHYSICAL_BUTTONS_NOPCB] = {INPUT_MAP_NOPCB};
+int8_t  input_map_PCB[NUMBER_OF_PHYSICAL_BUTTONS_PCB] = {INPUT_MAP_PCB};
 
 struct buttonType buttons [NUMBER_OF_BUTTONS];                     // array for all buttons - type definition see fabi.h
 struct buttonDebouncerType buttonDebouncers [NUMBER_OF_BUTTONS];   // array for all buttonsDebouncers - type definition see fabi.h
 char   keystringBuffer[KEYSTRING_BUFFER_LEN]; // buffer for all string parameters for the buttons of a slot
+uint16_t keystringOffsets[NUMBER_OF_BUTTONS + 1];  // start of every keystring in keystringBuffer (last: total length)
 
 uint8_t NUMBER_OF_PHYSICAL_BUTTONS;
+
+// port and bit of the digital pins 0..23 of the ATmega32u4, as in the pin tables of the 
+// Leonardo core (digital_pin_to_port_PGM, digital_pin_to_bit_mask_PGM), but as constant expressions
+#define PIN_PORT_B 0      // index into the port snapshot of readButtonPins()
+#define PIN_PORT_C 1
+#define PIN_PORT_D 2
+#define PIN_PORT_E 3
+#define PIN_PORT_F 4
+constexpr uint8_t pinPort[24] = { PIN_PORT_D, PIN_PORT_D, PIN_PORT_D, PIN_PORT_D, PIN_PORT_D, PIN_PORT_C, PIN_PORT_D, PIN_PORT_E,
+                                  PIN_PORT_B, PIN_PORT_B, PIN_PORT_B, PIN_PORT_B, PIN_PORT_D, PIN_PORT_C, PIN_PORT_B, PIN_PORT_B,
+                                  PIN_PORT_B, PIN_PORT_B, PIN_PORT_F, PIN_PORT_F, PIN_PORT_F, PIN_PORT_F, PIN_PORT_F, PIN_PORT_F };
+constexpr uint8_t pinBit[24] = { 2, 3, 1, 0, 4, 6, 7, 6, 4, 5, 6, 7, 6, 7, 3, 1, 2, 0, 7, 6, 5, 4, 1, 0 };
+
+// port snapshot index and bitmask of every switch input, built at compile time from the pin maps
+struct buttonPinType {
+  uint8_t port;
+  uint8_t mask;
+};
+
+template <uint8_t N> struct buttonPinTable {
+  buttonPinType pin[N];
+};
+
+template <int8_t... pins> constexpr buttonPinTable<sizeof...(pins)> makeButtonPinTable()
+{
+  return { { { pinPort[pins], (uint8_t) (1 << pinBit[pins]) }... } };
+}
+
+constexpr buttonPinTable<NUMBER_OF_PHYSICAL_BUTTONS_NOPCB> buttonPins_NOPCB PROGMEM = makeButtonPinTable<INPUT_MAP_NOPCB>();
+constexpr buttonPinTable<NUMBER_OF_PHYSICAL_BUTTONS_PCB> buttonPins_PCB PROGMEM = makeButtonPinTable<INPUT_MAP_PCB>();
+
+const buttonPinType * buttonPins = buttonPins_NOPCB.pin;   // table of the active pin map (PROGMEM), see initButtons()
+
 uint16_t buttonStates = 0;
-uint16_t pressure = 0;
+uint16_t pressure = 0;                   // baseline corrected pressure (10 bit, PRESSURE_NOMINAL at rest)
+uint16_t pressureFiltered = 0;           // low-pass filtered sensor value (12 bit, 4 fractional bits)
+uint16_t pressureBaseline = 0;           // tracked sensor value at rest (12 bit, 4 fractional bits)
+uint8_t  sipState = PRESSURE_IDLE;      // classification of the current sip (soft / strong)
+uint8_t  puffState = PRESSURE_IDLE;     // classification of the current puff (soft / strong)
+uint8_t  sipDecisionTime = 0;           // ticks since the sip started
+uint8_t  puffDecisionTime = 0;          // ticks since the puff started
+uint8_t  sipLevels = 0;                 // exceeded sip thresholds: bit0 soft, bit1 strong (with hysteresis)
+uint8_t  puffLevels = 0;                // exceeded puff thresholds: bit0 soft, bit1 strong (with hysteresis)
+uint32_t pressureTimestamp = 0;         // time of the last filter update (see updatePressure())
 uint8_t reportRawValues = 0;
 uint8_t reportSlotParameters = 0;
 uint8_t valueReportCount = 0;
 
+// switch edge event queue: single producer (pin change ISR), single consumer (main loop)
+volatile struct buttonEventType buttonEvents[BUTTON_EVENT_QUEUE_LEN];
+volatile uint8_t buttonEventHead = 0;      // written by the ISR only
+volatile uint8_t buttonEventTail = 0;      // written by the main loop only
+volatile uint16_t capturedButtonStates = 0; // switch states as seen by the last capture
+uint16_t interruptButtons = 0;             // physical buttons whose pins can trigger an interrupt
+uint16_t edgeHandledButtons = 0;           // buttons which got their debouncing sample from an edge event in this period
+uint32_t sampleTimestamp = 0;              // micros() of the switch sample which is currently debounced
+
+#ifdef LATENCY_HISTOGRAM
+uint32_t buttonEdgeTimestamps[NUMBER_OF_BUTTONS];  // time of the first pressed sample of every button
+uint32_t sipTimestamp = 0;                         // micros() when the current sip started
+uint32_t puffTimestamp = 0;                        // micros() when the current puff started
+#endif
+
+/**
+   @name captureButtonEdges
+   @param none
+   @return none
+
+   called from the pin change / external interrupts of the switch inputs:
+   reads all interrupt capable switches, and pushes a timestamped event into the 
+   event queue for every switch which changed its state since the last capture.
+   if the queue is full, the edge is dropped (the periodic polling in updateButtons() still catches it)
+*/
+void captureButtonEdges() {
+  uint32_t timestamp = micros();
+  uint16_t actStates = readButtonPins() & interruptButtons;
+  uint16_t changed = actStates ^ capturedButtonStates;
+  capturedButtonStates = actStates;
+
+  for (uint8_t i = 0; changed; i++, changed >>= 1) {
+    if (!(changed & 1)) continue;
+    uint8_t next = (buttonEventHead + 1) & (BUTTON_EVENT_QUEUE_LEN - 1);
+    if (next == buttonEventTail) return;   // queue full
+    buttonEvents[buttonEventHead].timestamp = timestamp;
+    buttonEvents[buttonEventHead].button = i;
+    buttonEvents[buttonEventHead].state = (actStates & (1 << i)) ? BUTTON_PRESSED : BUTTON_RELEASED;
+    buttonEventHead = next;
+  }
+}
+
+/**
+   pin change interrupt for the switches connected to PORTB
+*/
+ISR(PCINT0_vect) {
+  captureButtonEdges();
+}
+
+/**
+   @name readButtonPins
+   @param none
+   @return uint16_t  bitmask of the pressed physical switches (bit n == switch n)
+
+   reads the PINx registers which can hold switch inputs once 
+   and returns the snapshot of all physical switches (active low) as one bitmask
+*/
+uint16_t readButtonPins() {
+  uint8_t portStates[BUTTON_PORTS] = { PINB, PINC, PIND, PINE, PINF };
+  uint16_t pressed = 0;
+
+  for (uint8_t i = 0; i < NUMBER_OF_PHYSICAL_BUTTONS; i++)
+    if (!(portStates[pgm_read_byte(&buttonPins[i].port)] & pgm_read_byte(&buttonPins[i].mask)))
+      pressed |= (1 << i);
+  return (pressed);
+}
+
+/**
+   @name initButtonInterrupts
+   @param none
+   @return none
+
+   enables the external interrupt (INTn) or pin change interrupt (PCINTn) for all
+   switch inputs which support one. Switches on other pins are only polled.
+   the interrupt masks (EIMSK, PCICR, PCMSK0) of a previous configuration are cleared first.
+   must be called with interrupts disabled, see initButtons()
+*/
+void initButtonInterrupts() {
+  for (uint8_t i = 0; i < NUMBER_OF_PHYSICAL_BUTTONS; i++)
+    if (digitalPinToInterrupt(input_map[i]) != NOT_AN_INTERRUPT) detachInterrupt(digitalPinToInterrupt(input_map[i]));
+  PCICR &= ~(1 << PCIE0);
+  PCMSK0 = 0;
+
+  interruptButtons = 0;
+  for (uint8_t i = 0; i < NUMBER_OF_PHYSICAL_BUTTONS; i++) {
+    uint8_t pin = input_map[i];
+    if (digitalPinToInterrupt(pin) != NOT_AN_INTERRUPT) {
+      attachInterrupt(digitalPinToInterrupt(pin), captureButtonEdges, CHANGE);
+      interruptButtons |= (1 << i);
+    }
+    else if (digitalPinToPCICR(pin)) {
+      *digitalPinToPCMSK(pin) |= (1 << digitalPinToPCMSKbit(pin));
+      *digitalPinToPCICR(pin) |= (1 << digitalPinToPCICRbit(pin));
+      interruptButtons |= (1 << i);
+    }
+  }
+  captureButtonEdges();     // get initial states
+  buttonEventTail = buttonEventHead;
+}
+
+/**
+   @name getButtonEvent
+   @param struct buttonEventType * event  the event is copied into this struct
+   @return uint8_t  1 if an event was available, 0 if the queue is empty
+
+   removes the oldest switch edge event from the event queue
+*/
+uint8_t getButtonEvent(struct buttonEventType * event) {
+  uint8_t tail = buttonEventTail;
+  if (tail == buttonEventHead) return (0);
+  event->timestamp = buttonEvents[tail].timestamp;
+  event->button = buttonEvents[tail].button;
+  event->state = buttonEvents[tail].state;
+  buttonEventTail = (tail + 1) & (BUTTON_EVENT_QUEUE_LEN - 1);
+  return (1);
+}
+
+/**
+   @name handleButtonEvents
+   @param none
+   @return none
+
+   consumes the captured switch edges, called in every loop iteration.
+   the first edge of a button within one update period is passed to the debouncer immediately,
+   (so that a valid press does not have to wait for the next periodic update), 
+   the periodic sample of this button is then skipped. Further edges in the same period are bounces,
+   they are discarded (the next periodic update samples the current state).
+*/
+void handleButtonEvents() {
+  struct buttonEventType event;
+
+  while (getButtonEvent(&event)) {
+    if (event.button >= NUMBER_OF_PHYSICAL_BUTTONS) continue;
+    if (edgeHandledButtons & (1 << event.button)) continue;
+    edgeHandledButtons |= (1 << event.button);
+    sampleTimestamp = event.timestamp;
+    handleButton(event.button, event.button + 6, event.state);
+  }
+}
+
 /**
    @name initButtons
    @param none
@@ -39,15 +225,25 @@ uint8_t valueReportCount = 0;
 */
 void initButtons() {
   
+  // the switch interrupts use the pin tables, which are changed here 
+  // (initButtons() is called again at runtime, e.g. by AT RS)
+  noInterrupts();
+
   // update pin mapping for PCB version 
   if (PCBversion)  {
     NUMBER_OF_PHYSICAL_BUTTONS = NUMBER_OF_PHYSICAL_BUTTONS_PCB;
     memcpy(input_map, input_map_PCB, NUMBER_OF_PHYSICAL_BUTTONS);
+    buttonPins = buttonPins_PCB.pin;
+  }
+  else {
+    NUMBER_OF_PHYSICAL_BUTTONS = NUMBER_OF_PHYSICAL_BUTTONS_NOPCB;
+    buttonPins = buttonPins_NOPCB.pin;
   }
-  else NUMBER_OF_PHYSICAL_BUTTONS = NUMBER_OF_PHYSICAL_BUTTONS_NOPCB;
 
   for (int i = 0; i < NUMBER_OF_PHYSICAL_BUTTONS; i++) // initialize physical buttons and bouncers
     pinMode (input_map[i], INPUT_PULLUP);   // configure the pins for input mode with pullup resistors
+  initButtonInterrupts();
+  interrupts();
 
   // initialize button array
   for (int i = 0; i < NUMBER_OF_BUTTONS; i++)  { 
@@ -55,6 +251,143 @@ void initButtons() {
     buttons[i].value = 0;
     keystringBuffer[i] = 0;
   }
+  indexKeystrings();
+  compileKeyActions();
+}
+
+/**
+   @name calibratePressure
+   @param none
+   @return none
+
+   sets filter and baseline to the current sensor value
+   (the sensor must be at rest, e.g. at startup or via AT CA)
+*/
+void calibratePressure() {
+  pressureFiltered = pressureBaseline = getPressure() << 4;
+  sipLevels = puffLevels = 0;
+  sipState = puffState = PRESSURE_IDLE;
+  pressure = PRESSURE_NOMINAL;
+}
+
+/**
+   @name thresholdLevel
+   @param int16_t threshold  threshold (10 bit, relative to PRESSURE_NOMINAL), greater than 0
+   @param uint8_t exceeded  1 if the threshold is currently exceeded
+   @return int16_t  the level which the deviation must exceed (12 bit units)
+
+   returns the threshold, or the release level (threshold minus hysteresis) if the threshold
+   is exceeded. The release level is at least half the threshold, so that a hysteresis (settings.sh)
+   as large as the threshold can not keep the action active at rest.
+*/
+int16_t thresholdLevel(int16_t threshold, uint8_t exceeded) {
+  int16_t level = threshold << 2;
+
+  if (exceeded) {
+    if (settings.sh < (uint16_t)(threshold / 2)) level -= settings.sh << 2;
+    else level -= level / 2;
+  }
+  return (level);
+}
+
+/**
+   @name updateLevels
+   @param uint8_t levels  currently exceeded thresholds (bit0: soft, bit1: strong)
+   @param int16_t deviation  deviation from the baseline in direction of the action (12 bit units)
+   @param int16_t softThreshold  soft threshold (10 bit, relative to PRESSURE_NOMINAL), or 0 if disabled
+   @param int16_t strongThreshold  strong threshold (10 bit, relative to PRESSURE_NOMINAL), or 0 if disabled
+   @return uint8_t  exceeded thresholds
+
+   compares the deviation against the thresholds: a threshold counts as exceeded
+   until the deviation falls below its release level (see thresholdLevel())
+*/
+uint8_t updateLevels(uint8_t levels, int16_t deviation, int16_t softThreshold, int16_t strongThreshold) {
+  uint8_t result = 0;
+
+  if ((softThreshold > 0) && (deviation > thresholdLevel(softThreshold, levels & 1)))
+    result |= 1;
+  if ((strongThreshold > 0) && (deviation > thresholdLevel(strongThreshold, levels & 2)))
+    result |= 2;
+  return (result);
+}
+
+/**
+   @name classifyPressure
+   @param uint8_t * state  the classification state of the sip or puff
+   @param uint8_t * decisionTime  ticks since the sip or puff started
+   @param uint8_t levels  exceeded thresholds (bit0: soft, bit1: strong)
+   @param uint8_t strongEnabled  1 if a strong action is configured
+   @return uint8_t  1 if a new sip or puff started
+
+   decides between soft and strong sip/puff: a sip/puff which reaches the strong
+   threshold within PRESSURE_DECISION_TIME is strong, otherwise it is soft.
+   Only one of both actions is issued until the pressure is back at rest.
+   If no strong action is configured, soft actions are issued without delay.
+   A soft sip/puff which ends before the decision is issued afterwards
+   (PRESSURE_SOFT_SHORT, as long as it was above the soft threshold).
+*/
+uint8_t classifyPressure(uint8_t * state, uint8_t * decisionTime, uint8_t levels, uint8_t strongEnabled) {
+  uint8_t started = 0;
+
+  if (!levels) {
+    if (*state == PRESSURE_DECIDING) *state = PRESSURE_SOFT_SHORT;    // decisionTime: ticks above the soft threshold
+    if ((*state != PRESSURE_SOFT_SHORT) || (!*decisionTime)) *state = PRESSURE_IDLE;
+    else (*decisionTime)--;
+    return (0);
+  }
+  if (*state == PRESSURE_SOFT_SHORT) *state = PRESSURE_SOFT;          // the next sip/puff continues the soft action
+  if (*state == PRESSURE_IDLE) {
+    *state = PRESSURE_DECIDING;
+    *decisionTime = 0;
+    started = 1;
+  }
+  if (*state == PRESSURE_DECIDING) {
+    if (levels & 2) *state = PRESSURE_STRONG;
+    else if ((levels & 1) && ((!strongEnabled) || (++(*decisionTime) >= PRESSURE_DECISION_TIME)))
+      *state = PRESSURE_SOFT;
+  }
+  return (started);
+}
+
+/**
+   @name updatePressure
+   @param none
+   @return none
+
+   filters the pressure sensor value and updates the sip/puff states:
+   the thresholds (settings.ts / tp / ss / sp) are taken relative to PRESSURE_NOMINAL
+   and applied to the deviation from the tracked baseline.
+   The baseline follows slow sensor drift while neither sip nor puff is active.
+*/
+void updatePressure() {
+  pressureTimestamp = millis();
+  int32_t reading = (uint32_t)getPressure() << 4;
+  pressureFiltered += (reading - (int32_t)pressureFiltered) >> PRESSURE_FILTER_SHIFT;
+
+  int16_t deviation = ((int32_t)pressureFiltered - (int32_t)pressureBaseline) >> 4;   // 12 bit units
+  int16_t softSip = settings.ts > 0 ? PRESSURE_NOMINAL - (int16_t)settings.ts : 0;
+  int16_t strongSip = settings.ss > 0 ? PRESSURE_NOMINAL - (int16_t)settings.ss : 0;
+  int16_t softPuff = settings.tp < 1023 ? (int16_t)settings.tp - PRESSURE_NOMINAL : 0;
+  int16_t strongPuff = settings.sp < 1023 ? (int16_t)settings.sp - PRESSURE_NOMINAL : 0;
+
+  sipLevels = updateLevels(sipLevels, -deviation, softSip, strongSip);
+  puffLevels = updateLevels(puffLevels, deviation, softPuff, strongPuff);
+
+  if (classifyPressure(&sipState, &sipDecisionTime, sipLevels, strongSip > 0)) {
+#ifdef LATENCY_HISTOGRAM
+    sipTimestamp = micros();
+#endif
+  }
+  if (classifyPressure(&puffState, &puffDecisionTime, puffLevels, strongPuff > 0)) {
+#ifdef LATENCY_HISTOGRAM
+    puffTimestamp = micros();
+#endif
+  }
+
+  if ((sipState == PRESSURE_IDLE) && (puffState == PRESSURE_IDLE))
+    pressureBaseline += ((int32_t)pressureFiltered - (int32_t)pressureBaseline) >> PRESSURE_BASELINE_SHIFT;
+
+  pressure = constrain(PRESSURE_NOMINAL + (deviation >> 2), 0, 1023);
 }
 
 /**
@@ -67,31 +400,50 @@ void initButtons() {
    perform live value reports
 */
 void updateButtons() {
-  pressure = analogRead(PRESSURE_SENSOR_PIN);
+  updatePressure();
+  uint16_t pinStates = readButtonPins();
+  sampleTimestamp = micros();
 
   // update button press / release events
+  // (skip buttons which already got their sample from an edge event, see handleButtonEvents())
   for (int i = 0; i < NUMBER_OF_PHYSICAL_BUTTONS; i++)
-    handleButton(i, i + 6, digitalRead(input_map[i]) == LOW ? BUTTON_PRESSED : BUTTON_RELEASED);
+    if (!(edgeHandledButtons & (1 << i)))
+      handleButton(i, i + 6, (pinStates & (1 << i)) ? BUTTON_PRESSED : BUTTON_RELEASED);
+  edgeHandledButtons = 0;
 
   // handle pressure sensor and perform sip/puff actions if enabled
-  if (settings.ts > 0)    handleButton(SIP_BUTTON, -1, pressure < settings.ts ? BUTTON_PRESSED : BUTTON_RELEASED);
-  if (settings.tp < 1023) handleButton(PUFF_BUTTON, -1, pressure > settings.tp ? BUTTON_PRESSED : BUTTON_RELEASED);
+  // (the latency of sip/puff actions includes the decision time, see classifyPressure())
+#ifdef LATENCY_HISTOGRAM
+  sampleTimestamp = sipTimestamp;
+#endif
+  if (settings.ts > 0)    handleButton(SIP_BUTTON, -1, (sipState == PRESSURE_SOFT) || (sipState == PRESSURE_SOFT_SHORT) ? BUTTON_PRESSED : BUTTON_RELEASED);
+  if (settings.ss > 0)    handleButton(STRONG_SIP_BUTTON, -1, sipState == PRESSURE_STRONG ? BUTTON_PRESSED : BUTTON_RELEASED);
+#ifdef LATENCY_HISTOGRAM
+  sampleTimestamp = puffTimestamp;
+#endif
+  if (settings.tp < 1023) handleButton(PUFF_BUTTON, -1, (puffState == PRESSURE_SOFT) || (puffState == PRESSURE_SOFT_SHORT) ? BUTTON_PRESSED : BUTTON_RELEASED);
+  if (settings.sp < 1023) handleButton(STRONG_PUFF_BUTTON, -1, puffState == PRESSURE_STRONG ? BUTTON_PRESSED : BUTTON_RELEASED);
 
   // if value report is active: send live values over serial
   if (reportRawValues)   {
     if (valueReportCount++ > 10) {      // report raw values !
-      Serial.print("VALUES:"); Serial.print(pressure); Serial.print(",");
+      hostSerial.beginTelemetry();          // note: the report is dropped if the host does not keep up
+      hostSerial.print("VALUES:"); hostSerial.print(pressure); hostSerial.print(",");
       for (uint8_t i = 0; i < NUMBER_OF_BUTTONS; i++)
       {
-        if (buttonStates & (1 << i)) Serial.print("1");
-        else Serial.print("0");
+        if (buttonStates & (1 << i)) hostSerial.print("1");
+        else hostSerial.print("0");
       }
-      Serial.print(",");
-      Serial.print(actSlot-1);
-      Serial.println("");
+      hostSerial.print(",");
+      hostSerial.print(actSlot-1);
+      hostSerial.println("");
+      hostSerial.endTelemetry();
       valueReportCount = 0;
     }
   }   
+
+  // binary live values (AT SB / AT BU)
+  updateTelemetry();
 }
 
 /**
@@ -106,7 +458,7 @@ void handlePress (int buttonIndex)
 {
   static uint32_t doublePressTimestamp = 0;
   #ifdef DEBUG_OUTPUT
-    Serial.print("press button "); Serial.print(buttonIndex);
+    hostSerial.print("press button "); hostSerial.print(buttonIndex);
   #endif
   
   // check if double press condition is met
@@ -114,7 +466,7 @@ void handlePress (int buttonIndex)
     if ((millis() - doublePressTimestamp) < settings.dp) {
       // Serial.println("skip to next Slot!");
       performCommand(CMD_NE, 0, 0, 0); // activate next slot
-      while (digitalRead(input_map[buttonIndex]) ==LOW) ;  // wait until button is released
+      while (readButtonPins() & (1 << buttonIndex)) ;  // wait until button is released
       return;
     }
   }
@@ -122,7 +474,9 @@ void handlePress (int buttonIndex)
   doublePressTimestamp = millis();     // remember timestamp in order to detect double presses
 
   // perform the associated button action 
-  performCommand(buttons[buttonIndex].mode, buttons[buttonIndex].value, getKeystring(buttonIndex), 1);
+  // (key commands use the keycodes which were compiled when the slot was loaded)
+  if (!replayKeyActions(buttonIndex, buttons[buttonIndex].mode))
+    performCommand(buttons[buttonIndex].mode, buttons[buttonIndex].value, getKeystring(buttonIndex), 1);
 }
 
 
@@ -138,7 +492,7 @@ void handlePress (int buttonIndex)
 void handleRelease (int buttonIndex)
 {
   #ifdef DEBUG_OUTPUT
-    Serial.print("release button "); Serial.print(buttonIndex);
+    hostSerial.print("release button "); hostSerial.print(buttonIndex);
   #endif
   buttonStates &= ~(1 << buttonIndex); //save for reporting
   switch (buttons[buttonIndex].mode) {
@@ -147,7 +501,9 @@ void handleRelease (int buttonIndex)
     case CMD_HM: middleMouseButton = 0; break;
     case CMD_MX: moveX = 0; break;
     case CMD_MY: moveY = 0; break;
-    case CMD_KH: releaseSingleKeys(getKeystring(buttonIndex)); break;
+    case CMD_KH: 
+      if (!replayKeyActions(buttonIndex, CMD_KR)) releaseSingleKeys(getKeystring(buttonIndex));
+      break;
   }
 }
 
@@ -159,15 +515,15 @@ void handleRelease (int buttonIndex)
 
    checks if all buttons (and sip puff values) are in the released state
    returns true if yes, else false.
+   the pressure filter is updated at most once per tick period (DEFAULT_WAIT_TIME),
+   so that a busy wait on this function does not speed up the filter, baseline and decision time.
 */
 uint8_t allButtonsReleased() {
   uint8_t r=1;
-  for (int i = 0; i < NUMBER_OF_PHYSICAL_BUTTONS; i++)
-    if (digitalRead(input_map[i]) == LOW) r=0;
+  if (readButtonPins()) r=0;
 
-  uint16_t pressure= analogRead(PRESSURE_SENSOR_PIN);
-  if ((settings.ts > 0) && (pressure < settings.ts)) r=0;
-  if ((settings.tp < 1023) && (pressure > settings.tp)) r=0;
+  if (millis() - pressureTimestamp >= DEFAULT_WAIT_TIME) updatePressure();
+  if (sipLevels || puffLevels) r=0;
 
   return(r);
 }
@@ -193,6 +549,10 @@ void initDebouncers()
   // wait until all buttons released or timeout reached!
   uint32_t timeout=millis();
   while (!allButtonsReleased() && millis()-timeout<RELEASE_ALL_TIMEOUT);
+
+  // discard switch edges which were captured before
+  buttonEventTail = buttonEventHead;
+  edgeHandledButtons = 0;
 }
 
 
@@ -235,6 +595,9 @@ void handleButton(int i, int l, uint8_t actState)
 
   // handle button press detection
   if ((actState == BUTTON_PRESSED))  {
+#ifdef LATENCY_HISTOGRAM
+    if (buttonDebouncers[i].pressCount == 0) buttonEdgeTimestamps[i] = sampleTimestamp;
+#endif
     buttonDebouncers[i].releaseCount = 0;
     if ((buttonDebouncers[i].pressCount <= settings.tt >> 2) || (settings.tt == 0))
       buttonDebouncers[i].pressCount++;
@@ -242,7 +605,11 @@ void handleButton(int i, int l, uint8_t actState)
     // antitremor press check: hold button a minimum time before press is valid (settings.ap)  
     if (buttonDebouncers[i].pressCount == settings.ap) {
       buttonDebouncers[i].pressState = BUTTONSTATE_SHORT_PRESSED;
-      if (!longPressEnabled(i))  { handlePress(i); return; }  // issue the short press action !
+      if (!longPressEnabled(i))  {   // issue the short press action !
+        startLatencyMeasurement(i, buttonEdgeTimestamps[i]);
+        handlePress(i);
+        return;
+      }
     }
 
     // check for long press action 
@@ -279,6 +646,24 @@ void handleButton(int i, int l, uint8_t actState)
   }
 }
 
+/**
+   @name indexKeystrings
+   @param none
+   @return none
+
+   rebuilds the offset table of the keystrings, 
+   must be called after the keystringBuffer was written directly (e.g. slot load)
+*/
+void indexKeystrings ()
+{
+  uint16_t offset = 0;
+  for (int i = 0; i < NUMBER_OF_BUTTONS; i++) {
+    keystringOffsets[i] = offset;
+    offset += strlen(keystringBuffer + offset) + 1;
+  }
+  keystringOffsets[NUMBER_OF_BUTTONS] = offset;
+}
+
 /**
    @name getKeystring
    @param uint8_t button  the button index
@@ -288,14 +673,7 @@ void handleButton(int i, int l, uint8_t actState)
 */
 char * getKeystring (uint8_t button)
 {
-  char *s = keystringBuffer;
-
-  // bypass first n strings in the keystringBuffer array
-  for (int i = 0; i < button; i++) {
-    while (*s) s++;
-    s++;
-  }
-  return (s);
+  return (keystringBuffer + keystringOffsets[button]);
 }
 
 /**
@@ -308,34 +686,33 @@ char * getKeystring (uint8_t button)
 */
 uint16_t keystringMemUsage(uint8_t button)
 {
-  uint16_t sum = 0;
-  for (int i = button; i < NUMBER_OF_BUTTONS; i++)
-    sum += strlen(getKeystring(i)) + 1;
-  return (sum);
+  return (keystringOffsets[NUMBER_OF_BUTTONS] - keystringOffsets[button]);
 }
 
 /**
    @name setKeystring
    @param uint8_t button  the button index
-   @param char * text  the text to be stored
+   @param const char * text  the text to be stored
    @return none
 
    stores a new string/ASCII-text (for the given button) into the keyStringBuffer array
    all individual strings in the array are zero-terminated
 */
-void setKeystring (uint8_t button, char * text)
+void setKeystring (uint8_t button, const char * text)
 {
+  uint16_t oldLen = keystringOffsets[button + 1] - keystringOffsets[button] - 1;
+  uint16_t newLen = strlen(text);
 
   // check if new string fits into memory, cancel if not!
-  if (keystringMemUsage(0) - strlen(getKeystring(button)) + strlen(text) >= KEYSTRING_BUFFER_LEN)
+  if (keystringMemUsage(0) - oldLen + newLen >= KEYSTRING_BUFFER_LEN)
     return;
 
-  if (button < NUMBER_OF_BUTTONS - 1) {
-    uint16_t bytesToCopy = keystringMemUsage(button + 1);
-    int16_t delta = strlen(text) - strlen(getKeystring(button));
-
-    // move other strings in order to fit in the new one !
-    memmove(getKeystring(button + 1) + delta, getKeystring(button + 1), bytesToCopy);
+  // move the following strings in order to fit in the new one !
+  int16_t delta = newLen - oldLen;
+  if (delta) {
+    memmove(getKeystring(button + 1) + delta, getKeystring(button + 1), keystringMemUsage(button + 1));
+    for (int i = button + 1; i <= NUMBER_OF_BUTTONS; i++)
+      keystringOffsets[i] += delta;
   }
   strcpy(getKeystring(button), text);
 }
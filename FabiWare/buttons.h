@@ -19,11 +19,29 @@
 #define NUMBER_OF_PHYSICAL_BUTTONS_NOPCB 9  // number of connectable switches for no-PCB version
 #define NUMBER_OF_PHYSICAL_BUTTONS_PCB   8  // number of connectable switches for PCB version
 #define NUMBER_OF_LEDS     3                // number of connectable leds (no-PCB verion)
+#define BUTTON_PORTS       5                // I/O ports which can hold switch inputs (B, C, D, E, F)
+
+// pin numbers of the switch inputs (input_map[]) for the no-PCB and the PCB version
+#define INPUT_MAP_NOPCB  2, 3, 4, 5, 6, 7, 8, 9, 10
+#define INPUT_MAP_PCB    10, 16, 19, 5, 6, 7, 8, 9
 
 #define SIP_BUTTON    9
 #define PUFF_BUTTON  10
+#define STRONG_SIP_BUTTON  11
+#define STRONG_PUFF_BUTTON 12
 #define PRESSURE_SENSOR_PIN A0
 
+#define PRESSURE_NOMINAL      512           // sensor value at rest (10 bit), sip/puff thresholds are relative to this value
+#define PRESSURE_FILTER_SHIFT   2           // IIR low-pass: filtered += (reading - filtered) / 2^shift (every tick)
+#define PRESSURE_BASELINE_SHIFT 9           // baseline tracking while idle: baseline += (filtered - baseline) / 2^shift
+#define PRESSURE_DECISION_TIME 20           // ticks to wait for a strong sip/puff before a soft one is issued (100ms)
+
+#define PRESSURE_IDLE       0               // sip/puff classification states
+#define PRESSURE_DECIDING   1
+#define PRESSURE_SOFT       2
+#define PRESSURE_STRONG     3
+#define PRESSURE_SOFT_SHORT 4               // a soft sip/puff which ended while deciding: issued afterwards
+
 #define BUTTON_PRESSED  1
 #define BUTTON_RELEASED 0
 #define BUTTONSTATE_NOT_PRESSED   0
@@ -31,12 +49,24 @@
 #define BUTTONSTATE_LONG_PRESSED  2
 #define BUTTONSTATE_IDLE          3
 
+#define BUTTON_EVENT_QUEUE_LEN   16         // size of the switch edge event queue (must be a power of 2)
+
+struct buttonEventType {                    // a switch edge, captured and timestamped by the pin change interrupt
+  uint32_t timestamp;                       // micros() at the time of the edge
+  uint8_t  button;                          // index of the physical button
+  uint8_t  state;                           // BUTTON_PRESSED or BUTTON_RELEASED
+};
+
 void initButtons();
 void initDebouncers();
 void updateButtons();
+void handleButtonEvents();               // consume the captured switch edges
+uint8_t getButtonEvent(struct buttonEventType * event);
 void handlePress (int buttonIndex);      // a button was pressed
 void handleRelease (int buttonIndex);    // a button was released
 void handleButton(int i, int l, uint8_t b);  // button debouncing
 uint8_t allButtonsReleased();
+uint16_t readButtonPins();               // snapshot of all physical switches as bitmask
+void calibratePressure();                // use the current pressure as baseline
 
 #endif
@@ -20,14 +20,24 @@
 #include "display.h"
 #include "mouseControl.h"
 #include "toneFABI.h"
+#include "diagnostics.h"
+#include "telemetry.h"
 
 const char ERRORMESSAGE_NOT_FOUND[] = "E: not found";
-uint8_t macroRunning = 0;
+
+// state of the macro engine (see startMacro() / updateMacro())
+char macroBuffer[MAX_CMDLEN];      // copy of the running macro
+uint8_t macroPos = 0;              // position of the next macro command in macroBuffer
+uint8_t macroRunning = 0;          // a macro is in progress
+uint8_t macroStepActive = 0;       // a macro command is currently executed
+uint32_t macroWaitTimestamp = 0;   // start time of the current wait command (AT WA)
+uint16_t macroWaitTime = 0;        // duration of the current wait command
+char macroTag[MAX_TAG_LEN + 1];    // tag of the command which started the macro ("AT#<tag> MA"), replied when it ends
 
 // AT Command list - defines all valid commands and their paramter types
 // Note that the order of this list must match with the command index enum (see commands.h)
 
-const struct atCommandType atCommands[] PROGMEM = {
+constexpr struct atCommandType atCommands[] PROGMEM = {
   {"ID"  , PARTYPE_NONE },  {"BM"  , PARTYPE_UINT }, {"CL"  , PARTYPE_NONE }, {"CR"  , PARTYPE_NONE },
   {"CM"  , PARTYPE_NONE },  {"CD"  , PARTYPE_NONE }, {"HL"  , PARTYPE_NONE }, {"HR"  , PARTYPE_NONE },
   {"HM"  , PARTYPE_NONE },  {"RL"  , PARTYPE_NONE }, {"RR"  , PARTYPE_NONE }, {"RM"  , PARTYPE_NONE },
@@ -40,9 +50,80 @@ const struct atCommandType atCommands[] PROGMEM = {
   {"TS"  , PARTYPE_UINT },  {"TP"  , PARTYPE_UINT }, {"MA"  , PARTYPE_STRING}, {"WA"  , PARTYPE_UINT  },
   {"TT"  , PARTYPE_UINT },  {"AP"  , PARTYPE_UINT }, {"AR"  , PARTYPE_UINT},  {"AI"  , PARTYPE_UINT  },
   {"FR"  , PARTYPE_NONE },  {"BT"  , PARTYPE_UINT }, {"BC"  , PARTYPE_STRING}, {"DP" , PARTYPE_UINT  },
-  {"AD"  , PARTYPE_UINT },  {"SC"  , PARTYPE_STRING }, {"UG", PARTYPE_NONE }
+  {"AD"  , PARTYPE_UINT },  {"SC"  , PARTYPE_STRING }, {"UG", PARTYPE_NONE }, {"LH"  , PARTYPE_NONE },
+  {"PR"  , PARTYPE_NONE },  {"SH"  , PARTYPE_UINT }, {"CA"  , PARTYPE_NONE },
+  {"SS"  , PARTYPE_UINT },  {"SP"  , PARTYPE_UINT }, {"ED"  , PARTYPE_NONE }, {"EI"  , PARTYPE_STRING},
+  {"EW"  , PARTYPE_STRING}, {"TQ"  , PARTYPE_NONE }, {"SB"  , PARTYPE_UINT },
+  {"BU"  , PARTYPE_UINT },  {"EF"  , PARTYPE_NONE }
 };
 
+static_assert(sizeof(atCommands) / sizeof(atCommands[0]) == NUM_COMMANDS,
+              "atCommands[] does not match the command index enum");
+
+/**
+   @name commandHash
+   @param char c1, char c2  the (uppercase) command identifier
+   @return uint8_t  hash value (0 - COMMAND_HASH_SIZE-1)
+
+   multiplicative hash of a two-letter command identifier (upper byte of the 16 bit product)
+*/
+constexpr uint8_t commandHash(char c1, char c2)
+{
+  return ((uint16_t)((((uint16_t)(uint8_t)c1 << 8) | (uint8_t)c2) * COMMAND_HASH_FACTOR)) >> 8;
+}
+
+constexpr uint8_t commandHash(uint8_t cmd)
+{
+  return commandHash(atCommands[cmd].atCmd[0], atCommands[cmd].atCmd[1]);
+}
+
+// compile time evaluation of the lookup table: the command with the given hash value (or COMMAND_NONE)
+constexpr uint8_t findCommand(uint8_t hash, uint8_t cmd)
+{
+  return (cmd >= NUM_COMMANDS) ? COMMAND_NONE :
+         (commandHash(cmd) == hash) ? cmd : findCommand(hash, cmd + 1);
+}
+
+// compile time check that no two commands have the same hash value
+constexpr bool hashCollision(uint8_t cmd, uint8_t other)
+{
+  return (other >= NUM_COMMANDS) ? false :
+         (commandHash(cmd) == commandHash(other)) || hashCollision(cmd, other + 1);
+}
+
+constexpr bool hashIsPerfect(uint8_t cmd)
+{
+  return (cmd >= NUM_COMMANDS) ? true : !hashCollision(cmd, cmd + 1) && hashIsPerfect(cmd + 1);
+}
+
+static_assert(hashIsPerfect(0), "command hash collision: choose another COMMAND_HASH_FACTOR");
+
+#define COMMAND_ENTRY_4(h)  findCommand(h, 0), findCommand(h + 1, 0), findCommand(h + 2, 0), findCommand(h + 3, 0)
+#define COMMAND_ENTRY_16(h) COMMAND_ENTRY_4(h), COMMAND_ENTRY_4(h + 4), COMMAND_ENTRY_4(h + 8), COMMAND_ENTRY_4(h + 12)
+#define COMMAND_ENTRY_64(h) COMMAND_ENTRY_16(h), COMMAND_ENTRY_16(h + 16), COMMAND_ENTRY_16(h + 32), COMMAND_ENTRY_16(h + 48)
+
+// command lookup table: command index for every hash value
+constexpr uint8_t commandTable[COMMAND_HASH_SIZE] PROGMEM = {
+  COMMAND_ENTRY_64(0), COMMAND_ENTRY_64(64), COMMAND_ENTRY_64(128), COMMAND_ENTRY_64(192)
+};
+
+/**
+   @name lookupCommand
+   @param char c1, char c2  the (uppercase) command identifier
+   @return int8_t  index of the command (see enum atCommands), -1 if not found
+
+   finds a command via the perfect hash table, without scanning the command list
+*/
+int8_t lookupCommand (char c1, char c2)
+{
+  uint8_t cmd = pgm_read_byte_near(&commandTable[commandHash(c1, c2)]);
+  if ((cmd != COMMAND_NONE) &&
+      (c1 == pgm_read_byte_near(&(atCommands[cmd].atCmd[0]))) &&
+      (c2 == pgm_read_byte_near(&(atCommands[cmd].atCmd[1]))))
+    return (cmd);
+  return (-1);
+}
+
 /**
    @name makehex
    @param uint32_t val
@@ -70,28 +151,31 @@ void makehex(uint32_t val, char* str) {
    @param none
    @return none
 
-   prints the current configuration slot settings to Serial
+   prints the current configuration slot settings to hostSerial
 */
 void printCurrentSlot()
 {
   char tmp[10];
-  Serial.print(F("Slot:"));  Serial.println(settings.slotname);
-  Serial.print(F("AT WS ")); Serial.println(settings.ws);
-  Serial.print(F("AT SC ")); makehex(settings.sc, tmp); Serial.println(tmp);
-  Serial.print(F("AT TS ")); Serial.println(settings.ts);
-  Serial.print(F("AT TP ")); Serial.println(settings.tp);
-  Serial.print(F("AT TT ")); Serial.println(settings.tt);
-  Serial.print(F("AT AP ")); Serial.println(settings.ap);
-  Serial.print(F("AT AR ")); Serial.println(settings.ar);
-  Serial.print(F("AT AI ")); Serial.println(settings.ai);
-  Serial.print(F("AT BT ")); Serial.println(settings.bt);
-  Serial.print(F("AT DP ")); Serial.println(settings.dp);
-  Serial.print(F("AT AD ")); Serial.println(settings.ad);
+  hostSerial.print(F("Slot:"));  hostSerial.println(settings.slotname);
+  hostSerial.print(F("AT WS ")); hostSerial.println(settings.ws);
+  hostSerial.print(F("AT SC ")); makehex(settings.sc, tmp); hostSerial.println(tmp);
+  hostSerial.print(F("AT TS ")); hostSerial.println(settings.ts);
+  hostSerial.print(F("AT TP ")); hostSerial.println(settings.tp);
+  hostSerial.print(F("AT SS ")); hostSerial.println(settings.ss);
+  hostSerial.print(F("AT SP ")); hostSerial.println(settings.sp);
+  hostSerial.print(F("AT SH ")); hostSerial.println(settings.sh);
+  hostSerial.print(F("AT TT ")); hostSerial.println(settings.tt);
+  hostSerial.print(F("AT AP ")); hostSerial.println(settings.ap);
+  hostSerial.print(F("AT AR ")); hostSerial.println(settings.ar);
+  hostSerial.print(F("AT AI ")); hostSerial.println(settings.ai);
+  hostSerial.print(F("AT BT ")); hostSerial.println(settings.bt);
+  hostSerial.print(F("AT DP ")); hostSerial.println(settings.dp);
+  hostSerial.print(F("AT AD ")); hostSerial.println(settings.ad);
   for (int i = 0; i < NUMBER_OF_BUTTONS; i++) {
-    Serial.print(F("AT BM "));
-    if (i < 9) Serial.print('0');
-    Serial.println(i + 1);
-    Serial.print(F("AT "));
+    hostSerial.print(F("AT BM "));
+    if (i < 9) hostSerial.print('0');
+    hostSerial.println(i + 1);
+    hostSerial.print(F("AT "));
     int actCmd = buttons[i].mode;
     char cmdStr[4];
 
@@ -101,18 +185,139 @@ void printCurrentSlot()
     }
     
     strcpy_FM(cmdStr, (uint_farptr_t_FM) atCommands[actCmd].atCmd);
-    Serial.print(cmdStr);
+    hostSerial.print(cmdStr);
     switch (pgm_read_byte_near(&(atCommands[actCmd].partype)))
     {
       case PARTYPE_UINT:
-      case PARTYPE_INT:  Serial.print(' '); Serial.print(buttons[i].value); break;
-      case PARTYPE_STRING: Serial.print(' '); Serial.print(getKeystring(i)); break;
+      case PARTYPE_INT:  hostSerial.print(' '); hostSerial.print(buttons[i].value); break;
+      case PARTYPE_STRING: hostSerial.print(' '); hostSerial.print(getKeystring(i)); break;
+    }
+    hostSerial.println("");
+  }
+}
+
+
+
+/**
+   @name startMacro
+   @param char * macro - the command macro (multiple commands, separated by semicolon)
+   @return none
+
+   starts the execution of a command macro. The macro is executed by updateMacro(),
+   one command per update period, so that buttons and serial commands stay responsive.
+   if the same macro is already running, MACRO_RETRIGGER_POLICY decides if it is restarted or not,
+   a different macro replaces the running one.
+   a tagged command ("AT#<tag> MA ...") is answered with "#<tag> OK" when the macro has finished
+   or was replaced (see stopMacro()), not when it is started.
+*/
+void startMacro(char * macro)
+{
+  char tag[MAX_TAG_LEN + 1];
+
+  if (!macro) return;
+  if (macroRunning && !strcmp(macro, macroBuffer) && (MACRO_RETRIGGER_POLICY == MACRO_RETRIGGER_IGNORE))
+    return;
+
+  hostSerial.takeTag(tag);
+  stopMacro();
+  strcpy(macroTag, tag);
+  strncpy(macroBuffer, macro, MAX_CMDLEN - 1);  // make a copy, the keystring or command buffer could change
+  macroBuffer[MAX_CMDLEN - 1] = 0;
+  macroPos = 0;
+  macroRunning = 1;
+}
+
+/**
+   @name stopMacro
+   @param none
+   @return none
+
+   cancels a running macro and stops mouse movements which were started by the macro,
+   sends the reply of the tagged command which started the macro
+*/
+void stopMacro()
+{
+  if (!macroRunning) return;
+  macroRunning = 0;
+  macroWaitTime = 0;
+  moveX = 0; moveY = 0;
+  if (macroTag[0]) {
+    hostSerial.print('#');
+    hostSerial.print(macroTag);
+    hostSerial.println(F(" OK"));
+    macroTag[0] = 0;
+  }
+}
+
+/**
+   @name updateMacro
+   @param none
+   @return none
+
+   executes the next command of a running macro, called once per update period.
+   a wait command (AT WA) suspends the macro until the wait time has passed.
+*/
+void updateMacro()
+{
+  char macroCommand[MAX_MACROCMD_LEN];
+  uint8_t actMacroCmdLen = 0;
+
+  if (!macroRunning) return;
+
+  if (macroWaitTime) {
+    if (millis() - macroWaitTimestamp < macroWaitTime) return;
+    macroWaitTime = 0;
+  }
+
+  char *cmdChar = macroBuffer + macroPos;
+  if (!(*cmdChar)) {    // end of macro reached
+    stopMacro();
+    return;
+  }
+
+  // get next command, separator: ';'
+  while ((*cmdChar) && (*cmdChar != ';') && (actMacroCmdLen < MAX_MACROCMD_LEN - 1)) {
+    // use backslash for passing special characters (; or \)
+    if (*cmdChar == '\\') cmdChar++;
+    macroCommand[actMacroCmdLen] = *cmdChar;
+    if (*cmdChar) {
+      actMacroCmdLen++;
+      cmdChar++;
     }
-    Serial.println("");
   }
+  macroCommand[actMacroCmdLen] = 0;
+  if (*cmdChar) cmdChar++;
+  macroPos = cmdChar - macroBuffer;   // note: the command could start a new macro
+
+  // now execute current macro command!
+  // Serial.print(F("execute: "));
+  // Serial.println(macroCommand);
+  macroStepActive = 1;
+  parseCommand(macroCommand);
+  macroStepActive = 0;
 }
 
 
+/**
+   @name loadSlot
+   @param char * slotname - the name of the slot
+   @return uint8_t - 1 if the slot was loaded, 0 if not found
+
+   loads a configuration slot from EEPROM and updates the slot indication
+*/
+uint8_t loadSlot(char * slotname)
+{
+  release_all();
+  if (!readFromEEPROM(slotname)) return (0);
+  if (PCBversion) {
+    updateNeoPixelColor(actSlot);    // update the Slot color of the LED
+    toneFABI(actSlot, 150);
+    writeSlot2Display();             // update the info on the Display
+  }
+  initDebouncers();
+  return (1);
+}
+
 
 /**
    @name performCommand
@@ -123,7 +328,7 @@ void printCurrentSlot()
    @return none
 
    perform a command / button action
-   this function is either called directly from parser.cpp (in case an AT command was received from the Serial interface)
+   this function is either called directly from parser.cpp (in case an AT command was received from the hostSerial interface)
    or if a button press is valid and the associated function action shall be performed
 */
 void performCommand (uint8_t cmd, int16_t parNum, char * parString, int8_t periodicMouseMovement)
@@ -135,8 +340,8 @@ void performCommand (uint8_t cmd, int16_t parNum, char * parString, int8_t perio
   if (actButton != 0)
   {
 #ifdef DEBUG_OUTPUT
-    Serial.print(F("got new mode for button ")); Serial.print(actButton); Serial.print(':');
-    Serial.print(cmd); Serial.print(','); Serial.print(parNum); Serial.print(','); Serial.println(parString);
+    hostSerial.print(F("got new mode for button ")); hostSerial.print(actButton); hostSerial.print(':');
+    hostSerial.print(cmd); hostSerial.print(','); hostSerial.print(parNum); hostSerial.print(','); hostSerial.println(parString);
 #endif
 
     // store action command and numerical parameter into button array
@@ -146,14 +351,15 @@ void performCommand (uint8_t cmd, int16_t parNum, char * parString, int8_t perio
     // store the string parameter into the keystringBuffer array
     if (parString == 0) setKeystring(actButton - 1, "");
     else setKeystring(actButton - 1, parString);
+    compileKeyActions();
     actButton = 0;
 #ifdef DEBUG_OUTPUT
-    Serial.print("Used RAM for Keystrings:"); Serial.print(keystringMemUsage(0));
-    Serial.print(" (free: "); Serial.print(KEYSTRING_BUFFER_LEN - keystringMemUsage(0));
-    Serial.println(")");
+    hostSerial.print("Used RAM for Keystrings:"); hostSerial.print(keystringMemUsage(0));
+    hostSerial.print(" (free: "); hostSerial.print(KEYSTRING_BUFFER_LEN - keystringMemUsage(0));
+    hostSerial.println(")");
 
     for (int i = 0; i < NUMBER_OF_BUTTONS; i++) {
-      Serial.print("Keystring "); Serial.print(i); Serial.print(":"); Serial.println(getKeystring(i));
+      hostSerial.print("Keystring "); hostSerial.print(i); hostSerial.print(":"); hostSerial.println(getKeystring(i));
     }
 #endif
     return;
@@ -164,188 +370,188 @@ void performCommand (uint8_t cmd, int16_t parNum, char * parString, int8_t perio
 
   switch (cmd) {
     case CMD_ID:
-      Serial.println(F(VERSION_STRING));
+      hostSerial.println(F(VERSION_STRING));
       break;
     case CMD_BM:
       release_all();
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("set mode for button "));
-      Serial.println(parNum);
+      hostSerial.print(F("set mode for button "));
+      hostSerial.println(parNum);
 #endif
       if ((parNum > 0) && (parNum <= NUMBER_OF_BUTTONS))
         actButton = parNum;
-      else  Serial.println('?');
+      else  hostSerial.println('?');
       break;
 
     case CMD_CL:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("click left"));
+      hostSerial.println(F("click left"));
 #endif
       leftMouseButton = 1;  leftClickRunning = DEFAULT_CLICK_TIME;
       break;
     case CMD_CR:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("click right"));
+      hostSerial.println(F("click right"));
 #endif
       rightMouseButton = 1; rightClickRunning = DEFAULT_CLICK_TIME;
       break;
     case CMD_CD:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("click double"));
+      hostSerial.println(F("click double"));
 #endif
       leftMouseButton = 1;  doubleClickRunning = DEFAULT_CLICK_TIME * DOUBLECLICK_MULTIPLIER;
       break;
     case CMD_CM:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("click middle"));
+      hostSerial.println(F("click middle"));
 #endif
       middleMouseButton = 1; middleClickRunning = DEFAULT_CLICK_TIME;
       break;
     case CMD_HL:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("hold left"));
+      hostSerial.println(F("hold left"));
 #endif
       leftMouseButton = 1;
       break;
     case CMD_HR:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("hold right"));
+      hostSerial.println(F("hold right"));
 #endif
       rightMouseButton = 1;
       break;
     case CMD_HM:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("hold middle"));
+      hostSerial.println(F("hold middle"));
 #endif
       middleMouseButton = 1;
       break;
     case CMD_RL:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("release left"));
+      hostSerial.println(F("release left"));
 #endif
       leftMouseButton = 0;
       break;
     case CMD_RR:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("release right"));
+      hostSerial.println(F("release right"));
 #endif
       rightMouseButton = 0;
       break;
     case CMD_RM:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("release middle"));
+      hostSerial.println(F("release middle"));
 #endif
       middleMouseButton = 0;
       break;
     case CMD_SC:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("slot color"));
-      Serial.println((uint32_t)strtol(parString, NULL, 0));
+      hostSerial.println(F("slot color"));
+      hostSerial.println((uint32_t)strtol(parString, NULL, 0));
 #endif
       settings.sc = (uint32_t)strtol(parString, NULL, 0);
       break;
     case CMD_TL:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("toggle left"));
+      hostSerial.println(F("toggle left"));
 #endif
       leftMouseButton ^= 1;
       break;
     case CMD_TR:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("toggle right"));
+      hostSerial.println(F("toggle right"));
 #endif
       rightMouseButton ^= 1;
       break;
     case CMD_TM:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("toggle middle"));
+      hostSerial.println(F("toggle middle"));
 #endif
       middleMouseButton ^= 1;
       break;
     case CMD_WU:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("wheel up"));
+      hostSerial.println(F("wheel up"));
 #endif
       if (settings.ws != 0) mouseScroll(-settings.ws);
       else mouseScroll(-DEFAULT_WHEEL_STEPSIZE);
       break;
     case CMD_WD:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("wheel down"));
+      hostSerial.println(F("wheel down"));
 #endif
       if (settings.ws != 0) mouseScroll(settings.ws);
       else mouseScroll(DEFAULT_WHEEL_STEPSIZE);
       break;
     case CMD_WS:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("wheel step"));
+      hostSerial.println(F("wheel step"));
 #endif
       settings.ws = parNum;
       break;
     case CMD_MX:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("mouse move x "));
-      Serial.println(parNum);
+      hostSerial.print(F("mouse move x "));
+      hostSerial.println(parNum);
 #endif
-      if (periodicMouseMovement || macroRunning) moveX = parNum;
+      if (periodicMouseMovement || macroStepActive) moveX = parNum;
       else mouseMove(parNum, 0);
       break;
     case CMD_MY:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("mouse move y "));
-      Serial.println(parNum);
+      hostSerial.print(F("mouse move y "));
+      hostSerial.println(parNum);
 #endif
-      if (periodicMouseMovement || macroRunning) moveY = parNum;
+      if (periodicMouseMovement || macroStepActive) moveY = parNum;
       else mouseMove(0, parNum);
 
       break;
     case CMD_KW:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("keyboard write: "));
-      Serial.println(parString);
+      hostSerial.print(F("keyboard write: "));
+      hostSerial.println(parString);
 #endif
       sendToKeyboard(parString);
       break;
     case CMD_KP:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("key press: "));
-      Serial.println(parString);
+      hostSerial.print(F("key press: "));
+      hostSerial.println(parString);
 #endif
       pressSingleKeys(parString);
       releaseSingleKeys(parString);
       break;
     case CMD_KH:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("key hold: "));
-      Serial.println(parString);
+      hostSerial.print(F("key hold: "));
+      hostSerial.println(parString);
 #endif
       pressSingleKeys(parString);
       break;
     case CMD_KT:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("key toggle: "));
-      Serial.println(parString);
+      hostSerial.print(F("key toggle: "));
+      hostSerial.println(parString);
 #endif
       toggleSingleKeys(parString);
       break;
     case CMD_KR:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("key release: "));
-      Serial.println(parString);
+      hostSerial.print(F("key release: "));
+      hostSerial.println(parString);
 #endif
       releaseSingleKeys(parString);
       break;
     case CMD_RA:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("release all"));
+      hostSerial.print(F("release all"));
 #endif
       release_all();
       break;
 
     case CMD_SA:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("save slot "));
-      Serial.println(parString);
+      hostSerial.print(F("save slot "));
+      hostSerial.println(parString);
 #endif
 
       if (strlen(parString) > 0) {
@@ -355,34 +561,25 @@ void performCommand (uint8_t cmd, int16_t parNum, char * parString, int8_t perio
 
         release_all();
         if (!saveToEEPROM(parString))
-          Serial.println(F("E: EEPROM full"));
-        else Serial.println("OK");
+          hostSerial.println(F("E: EEPROM full"));
+        else hostSerial.println("OK");
       }
       break;
     case CMD_LO:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("load slot: "));
-      Serial.println(parString);
+      hostSerial.print(F("load slot: "));
+      hostSerial.println(parString);
 #endif
       if (parString) {
         if (strlen (parString) > 0) {
-          release_all();
-          if (readFromEEPROM(parString)) {
-            if (PCBversion) {
-              updateNeoPixelColor(actSlot);    // update the Slot color of the LED
-              toneFABI(actSlot, 150);
-              writeSlot2Display();             // update the info on the Display
-            }
-            Serial.println("OK");
-            initDebouncers();
-          }
-          else Serial.println(ERRORMESSAGE_NOT_FOUND);
+          if (loadSlot(parString)) hostSerial.println("OK");
+          else hostSerial.println(ERRORMESSAGE_NOT_FOUND);
         }
       }
       break;
     case CMD_LA:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("load all slots"));
+      hostSerial.println(F("load all slots"));
 #endif
       release_all();
       reportSlotParameters = REPORT_ALL_SLOTS;
@@ -392,51 +589,57 @@ void performCommand (uint8_t cmd, int16_t parNum, char * parString, int8_t perio
       break;
     case CMD_LI:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("list slots: "));
+      hostSerial.println(F("list slots: "));
 #endif
       release_all();
       listSlots();
-      Serial.println("OK");
+      hostSerial.println("OK");
       break;
     case CMD_NE:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("load next slot"));
+      hostSerial.println(F("load next slot"));
       reportSlotParameters = REPORT_ONE_SLOT;
 #endif
 
-      release_all();
-      readFromEEPROM(0);
-      reportSlotParameters = REPORT_NONE;
-      if (PCBversion) {
-        updateNeoPixelColor(actSlot);    // update the Slot color of the LED
-        toneFABI(actSlot, 150);
-        writeSlot2Display();             //update the info on the Display
+      {
+#ifdef LOOP_PROFILER
+        uint32_t startTimestamp = micros();
+#endif
+        release_all();
+        readFromEEPROM(0);
+        reportSlotParameters = REPORT_NONE;
+        if (PCBversion) {
+          updateNeoPixelColor(actSlot);    // update the Slot color of the LED
+          toneFABI(actSlot, 150);
+          writeSlot2Display();             //update the info on the Display
+        }
+        initDebouncers();
+        profileSlotChange(startTimestamp, slotCacheHit);
       }
-      initDebouncers();
       break;
     case CMD_DE:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("delete slots"));
+      hostSerial.println(F("delete slots"));
 #endif
       release_all();
       if (deleteSlots(parString))
-        Serial.println("OK");
-      else Serial.println(ERRORMESSAGE_NOT_FOUND);
+        hostSerial.println("OK");
+      else hostSerial.println(ERRORMESSAGE_NOT_FOUND);
       break;
     case CMD_RS:
       deleteSlots(""); // delete all slots
       memcpy(&settings, &defaultSettings, sizeof(struct settingsType)); //load default values from flash
       initButtons(); //reset buttons
       if (!saveToEEPROM(settings.slotname)) {
-        Serial.println(F("E: EEPROM full"));
+        hostSerial.println(F("E: EEPROM full"));
       } else {
         readFromEEPROM(""); //load this slot
-        Serial.println("OK");
+        hostSerial.println("OK");
       }
       break;
     case CMD_NC:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("no command"));
+      hostSerial.println(F("no command"));
 #endif
       break;
     case CMD_SR:
@@ -444,107 +647,71 @@ void performCommand (uint8_t cmd, int16_t parNum, char * parString, int8_t perio
       break;
     case CMD_ER:
       reportRawValues = 0;
+      startTelemetry(0);
       break;
     case CMD_TS:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("set threshold sip"));
+      hostSerial.println(F("set threshold sip"));
 #endif
       settings.ts = parNum;
       break;
     case CMD_TP:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("set threshold puff"));
+      hostSerial.println(F("set threshold puff"));
 #endif
       settings.tp = parNum;
       break;
     case CMD_TT:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("set threshold time"));
+      hostSerial.println(F("set threshold time"));
 #endif
       settings.tt = parNum;
       break;
     case CMD_AP:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("set antitremor press"));
+      hostSerial.println(F("set antitremor press"));
 #endif
       settings.ap = parNum;
       break;
     case CMD_AR:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("set antitremor release"));
+      hostSerial.println(F("set antitremor release"));
 #endif
       settings.ar = parNum;
       break;
     case CMD_AI:
 #ifdef DEBUG_OUTPUT
-      Serial.println(F("set antitremor idle"));
+      hostSerial.println(F("set antitremor idle"));
 #endif
       settings.ai = parNum;
       break;
     case CMD_MA:
-      {
-#define MAX_MACROCMD_LEN 50
-        char macroCommand[MAX_MACROCMD_LEN];
-        int actMacroCmdLen = 0;
-        macroRunning = 1;
-
-        // execute a command macro
-        // make a copy from keystring because processing will be destructive...
-        uint8_t lastCmd = 0;
-
-        char *cmdChar = parString;
-
-        // do the macro stuff: feed single commands to parser, separator: ';'
-        do {
-          actMacroCmdLen = 0;
-          while ((*cmdChar) && (*cmdChar != ';') && (actMacroCmdLen < MAX_MACROCMD_LEN - 1)) {
-            // use backslash for passing special characters (; or \)
-            if (*cmdChar == '\\') cmdChar++;
-            macroCommand[actMacroCmdLen] = *cmdChar;
-            if (*cmdChar) {
-              actMacroCmdLen++;
-              cmdChar++;
-            }
-          }
-          macroCommand[actMacroCmdLen] = 0;
-
-          // now execute current macro command!
-          // Serial.print(F("execute: "));
-          // Serial.println(macroCommand);
-          parseCommand(macroCommand);
-          updateMouse();
-          if (*cmdChar) cmdChar++;
-        } while (*cmdChar);
-        macroRunning = 0; moveX = 0; moveY = 0;
-      }
+      startMacro(parString);
       break;
     case CMD_WA:
-      if (macroRunning) {
-        while (parNum > DEFAULT_WAIT_TIME) {
-          delay(DEFAULT_WAIT_TIME);
-          parNum -= DEFAULT_WAIT_TIME;
-          updateMouse();
-        }
+      if (macroStepActive) {      // yield: the macro is resumed when the wait time has passed
+        macroWaitTimestamp = millis();
+        macroWaitTime = parNum;
       }
-      delay(parNum);
+      else delay(parNum);
       break;
     case CMD_DP:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("Next Slot on Double Press = "));
-      Serial.println(parNum);
+      hostSerial.print(F("Next Slot on Double Press = "));
+      hostSerial.println(parNum);
 #endif
       settings.dp = parNum;
       break;
     case CMD_AD:
 #ifdef DEBUG_OUTPUT
-      Serial.print(F("Automatic Dwell Time = "));
-      Serial.println(parNum);
+      hostSerial.print(F("Automatic Dwell Time = "));
+      hostSerial.println(parNum);
 #endif
       settings.ad = parNum;
       break;
     case CMD_FR:
-      Serial.print(F("FREE EEPROM (%):"));
-      Serial.println(getfreeEEPROM());
+      hostSerial.print(F("FREE EEPROM (%):"));
+      hostSerial.println(getfreeEEPROM());
       break;
     case CMD_BT:
       settings.bt = parNum;
@@ -558,11 +725,79 @@ void performCommand (uint8_t cmd, int16_t parNum, char * parString, int8_t perio
     case CMD_UG:
       //we set this flag here, flushing & disabling serial port is done in loop()
       addonUpgrade = BTMODULE_UPGRADE_START;
-      Serial.println("Starting upgrade for BT addon!");
+      hostSerial.println("Starting upgrade for BT addon!");
       // Command for upgrade sent to ESP - triggering reset into factory reset mode
       Serial1.println("$UG");
       // delaying to ensure that UART command is sent and received
       delay(500);
       break;
+    case CMD_LH:
+      printLatencyHistogram();
+      break;
+    case CMD_PR:
+      printLoopProfile();
+      break;
+    case CMD_TQ:
+      hostSerial.printQueueStatistics();
+      break;
+    case CMD_SB:
+      startTelemetry(constrain(parNum, 0, 255));
+      break;
+    case CMD_BU:
+      startBurstCapture(constrain(parNum, 0, 255));
+      break;
+    case CMD_SH:
+#ifdef DEBUG_OUTPUT
+      hostSerial.println(F("set sip/puff hysteresis"));
+#endif
+      settings.sh = parNum;
+      break;
+    case CMD_SS:
+#ifdef DEBUG_OUTPUT
+      hostSerial.println(F("set threshold strong sip"));
+#endif
+      settings.ss = parNum;
+      break;
+    case CMD_SP:
+#ifdef DEBUG_OUTPUT
+      hostSerial.println(F("set threshold strong puff"));
+#endif
+      settings.sp = parNum;
+      break;
+    case CMD_ED:
+      release_all();
+      dumpEEPROM();
+      break;
+    case CMD_EI:
+      {
+        int16_t len = get_hex(parString, (uint8_t *)parString, EEPROM_IMAGE_HEADER_LEN);
+        release_all();
+        if ((len < 0) || (beginRestoreEEPROM((uint8_t *)parString, len) == RESTORE_ERROR))
+          hostSerial.println(F("E: invalid image"));
+      }
+      break;
+    case CMD_EW:
+      {
+        int16_t len = get_hex(parString, (uint8_t *)parString, EEPROM_IMAGE_CHUNK);
+        uint8_t result = restoreEEPROM((uint8_t *)parString, len);
+        if (result == RESTORE_DONE) {
+          if (PCBversion) {
+            updateNeoPixelColor(actSlot);
+            writeSlot2Display();
+          }
+          initDebouncers();
+          hostSerial.println("OK");
+        }
+        else if (result == RESTORE_ERROR) hostSerial.println(F("E: invalid image"));
+      }
+      break;
+    case CMD_EF:
+      storageFlush();
+      hostSerial.println(F("OK"));
+      break;
+    case CMD_CA:
+      calibratePressure();
+      hostSerial.println(F("OK"));
+      break;
   }
 }
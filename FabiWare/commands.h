@@ -13,19 +13,31 @@
 
      Supported AT-commands:  
      (sent via serial interface, 115200 baud, using spaces between parameters.  Enter (<cr>, ASCII-code 0x0d) finishes a command)
+     (slots can also be uploaded and read as binary frames, see binaryProtocol.h)
+     (commands can be tagged, e.g. "AT#17 LI": every response line then starts with "#17 ", see parseByte())
    
           AT              returns "OK"
           AT ID           returns identification string (e.g. "Fabi V2.3")
           AT BM <uint>    puts button into programming mode (e.g. "AT BM 2" -> next AT-command defines the new function for button 2)
-                          for the FABI, there are 11 buttons available (9 physical buttons, 2 virtual functions - sip / puff)
+                          for the FABI, there are 13 buttons available (9 physical buttons, 4 virtual functions - sip / puff / strong sip / strong puff)
           AT MA <string>  execute a command macro containing multiple commands (separated by semicolon) 
                           example: "AT MA MX 100;MY 100;CL;"  use backslash to mask semicolon: "AT MA KW \;;CL;" writes a semicolon and then clicks left 
+                          macros run in the background (one command per update period), buttons stay active.
+                          triggering a running macro again is ignored, starting another macro cancels the running one.
           AT WA <uint>    wait (given in milliseconds, useful for macro commands)
 
       Commands for changing settings:
           AT WS <uint>    set mouse wheel stepsize (e.g. "AT WS 3" sets the wheel stepsize to 3 rows)
           AT TS <uint>    threshold for sip action  (0-512)
           AT TP <uint>    threshold for puff action (512-1023)
+          AT SS <uint>    threshold for strong sip action  (0-512, 0=disable)
+          AT SP <uint>    threshold for strong puff action (512-1023, 1023=disable)
+                          (thresholds are relative to the tracked sensor value at rest, which is reported as 512)
+                          if a strong action is enabled, a sip/puff which reaches the strong threshold within 100ms
+                          triggers only the strong action (button 12 / 13), otherwise only the soft action (button 10 / 11).
+                          This delays soft actions by 100ms.
+          AT SH <uint>    hysteresis for sip and puff actions: release when pressure is back within threshold - hysteresis
+          AT CA           calibrate: use the current pressure sensor value as value at rest
           AT TT <uint>    threshold time for long press action (0=disable)
           AT DP <uint>    threshold time for double press to skip slot  (0=disable)
           AT AD <uint>    threshold time for automatic dwelling after mouse movement (0=disable)
@@ -76,17 +88,36 @@
           AT LO <string>  load button modes from eeprom slot (e.g. AT LO mouse1 -> loads profile named "mouse1")
           AT LA           load all slots (displays names and settings of all stored slots) 
           AT LI           list all saved slot names 
+          AT ED           dump the EEPROM slot memory as image: prints "AT EI" and "AT EW" lines (hex data), then "END"
+          AT EI <string>  begin writing an EEPROM image: image header as printed by AT ED
+          AT EW <string>  write the next part of an EEPROM image (hex data, max. 32 bytes). After the last part,
+                          the image is verified (crc) and replaces all slots ("OK"), else "E: invalid image"
+                          and the slots are kept (if the image does not fit next to them, they are cleared
+                          by AT EI and only a "default" slot with the current settings is saved)
+          AT EF           EEPROM flush: waits until all pending EEPROM writes are done, then prints "OK"
+                          (slots are written in the background after AT SA / AT DE)
           AT NE           next slot will be loaded (wrap around after last slot)
           AT DE <string>  delete slot of given name (deletes all stored slots if no string parameter is given)
           AT RS           resets FABI and restores default configuration (deletes EEPROM content and restores default Slot "slot1")
           AT NC           no command (idle operation)
           AT SR           start periodic reporting analog values (A0) over serial (starting with "VALUES:") 
-          AT ER           end reporting analog values
+          AT ER           end reporting analog values (also ends AT SB)
+          AT SB <uint>    start binary live value reports every <uint> ticks (1 = every tick, 0 = stop),
+                          packed FRAME_TELEMETRY frames with delta encoded pressure, see telemetry.h
+          AT BU <uint>    burst capture: record <uint> samples (max. 64) at every tick, then send them as
+                          FRAME_BURST frames (needs TELEMETRY_BURST, see fabi.h)
           AT FR           report free EEPROM bytes in % (starting with "FREE:") 
           AT BT <uint>    set bluetooth mode, 1=USB only, 2=BT only, 3=both(default)
                           (e.g. AT BT 2 -> send HID commands only via BT if BT-daughter board is available)
           AT BC <string>  sends parameter to external UART (mostly ESP32 Bluetooth Addon)
           AT UG           start addon upgrade, Serial ports are transparent until ("$FIN") is received.
+          AT LH           report and reset the switch-to-HID latency histograms (one line per transport and button,
+                          counts for <1,<2,<4,<8,<16,<32,<64,>=64 ms; needs LATENCY_HISTOGRAM, see fabi.h)
+          AT PR           report and reset the main loop profile (min/mean/max run time of every stage in microseconds,
+                          duration of slot changes (AT NE) from EEPROM and from the slot cache, number of ticks
+                          and tick overruns, worst tick periods; needs LOOP_PROFILER, see fabi.h)
+          AT TQ           report and reset the statistics of the serial transmit queue (peak fill level,
+                          bytes and lines of dropped raw value reports)
 
    supported key identifiers for key press command (AT KP):
  
@@ -116,7 +147,7 @@ enum atCommands {
   CMD_TL, CMD_TR, CMD_TM, CMD_WU, CMD_WD, CMD_WS, CMD_MX, CMD_MY, CMD_KW, CMD_KP, CMD_KH, CMD_KT, 
   CMD_KR, CMD_RA, CMD_SA, CMD_LO, CMD_LA, CMD_LI, CMD_NE, CMD_DE, CMD_RS, CMD_NC, CMD_SR, CMD_ER, CMD_TS, 
   CMD_TP, CMD_MA, CMD_WA, CMD_TT, CMD_AP, CMD_AR, CMD_AI, CMD_FR, CMD_BT, CMD_BC, CMD_DP, CMD_AD,
-  CMD_SC, CMD_UG, NUM_COMMANDS
+  CMD_SC, CMD_UG, CMD_LH, CMD_PR, CMD_SH, CMD_CA, CMD_SS, CMD_SP, CMD_ED, CMD_EI, CMD_EW, CMD_TQ, CMD_SB, CMD_BU, CMD_EF, NUM_COMMANDS
 };
 
 #define PARTYPE_NONE   0
@@ -124,7 +155,22 @@ enum atCommands {
 #define PARTYPE_INT    2
 #define PARTYPE_STRING 3
 
+#define COMMAND_HASH_SIZE   256       // size of the command lookup table (see lookupCommand())
+#define COMMAND_HASH_FACTOR 389U      // multiplier of the command hash, must give a collision free hash for all commands
+#define COMMAND_NONE        0xff      // lookup table entry for unused hash values
+
+#define MAX_MACROCMD_LEN 50           // maximum length of a single command in a macro
+
+#define MACRO_RETRIGGER_IGNORE  0     // triggering a running macro again has no effect
+#define MACRO_RETRIGGER_RESTART 1     // triggering a running macro again starts it over
+#define MACRO_RETRIGGER_POLICY  MACRO_RETRIGGER_IGNORE   // fixed at compile time, there is no AT command or slot setting for it
+
 void performCommand (uint8_t cmd, int16_t par1, char * keystring, int8_t periodicMouseMovement);
+int8_t lookupCommand (char c1, char c2);
+uint8_t loadSlot(char * slotname);
+void startMacro(char * macro);
+void stopMacro();
+void updateMacro();
 
 
 #endif
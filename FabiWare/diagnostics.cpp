@@ -0,0 +1,288 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: diagnostics.cpp - latency and timing measurements, loop profiler
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "fabi.h"
+#include "diagnostics.h"
+
+#ifdef LATENCY_HISTOGRAM
+
+uint16_t latencyHistogram[2][NUMBER_OF_BUTTONS][LATENCY_BUCKETS];  // press counts per transport, button and bucket
+uint32_t latencyTimestamp = 0;      // micros() of the switch edge which caused the pending press
+uint8_t  latencyButton = 0;         // button index of the pending press
+uint8_t  latencyPending = 0;        // transports which did not yet send a HID report for the pending press (bitmask)
+
+/**
+   @name startLatencyMeasurement
+   @param uint8_t button  index of the button which was pressed
+   @param uint32_t edgeTimestamp  micros() of the raw switch edge
+   @return none
+
+   called when a button press becomes valid: the next HID report
+   of every active transport finishes the measurement (see recordLatency())
+*/
+void startLatencyMeasurement(uint8_t button, uint32_t edgeTimestamp)
+{
+  latencyButton = button;
+  latencyTimestamp = edgeTimestamp;
+  latencyPending = 0;
+  if (settings.bt & 1) latencyPending |= (1 << LATENCY_USB);
+  if ((settings.bt & 2) && (isBluetoothAvailable())) latencyPending |= (1 << LATENCY_BT);
+}
+
+/**
+   @name recordLatency
+   @param uint8_t transport  LATENCY_USB or LATENCY_BT
+   @return none
+
+   called when a HID report was sent: if a press is pending for this transport,
+   the time since the switch edge is added to the histogram
+*/
+void recordLatency(uint8_t transport)
+{
+  if (!(latencyPending & (1 << transport))) return;
+  latencyPending &= ~(1 << transport);
+
+  uint32_t latency = micros() - latencyTimestamp;
+  if (latency > LATENCY_TIMEOUT) return;  // the press did not cause this report
+
+  uint16_t ms = latency / 1000;
+  uint8_t bucket = 0;
+  while (ms && (bucket < LATENCY_BUCKETS - 1)) { ms >>= 1; bucket++; }
+  if (latencyHistogram[transport][latencyButton][bucket] < 0xffff)
+    latencyHistogram[transport][latencyButton][bucket]++;
+}
+
+#endif
+
+/**
+   @name printLatencyHistogram
+   @param none
+   @return none
+
+   prints the switch-to-HID latency histograms of all buttons (USB and BT) 
+   and resets them. One line per button, with the counts of the buckets 
+   <1ms, <2ms, <4ms, <8ms, <16ms, <32ms, <64ms and >=64ms
+*/
+void printLatencyHistogram()
+{
+#ifdef LATENCY_HISTOGRAM
+  for (uint8_t t = 0; t < 2; t++) {
+    for (uint8_t i = 0; i < NUMBER_OF_BUTTONS; i++) {
+      hostSerial.print(t == LATENCY_USB ? F("LATENCY USB ") : F("LATENCY BT "));
+      if (i < 9) hostSerial.print('0');
+      hostSerial.print(i + 1); hostSerial.print(':');
+      for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+        if (b) hostSerial.print(',');
+        hostSerial.print(latencyHistogram[t][i][b]);
+        latencyHistogram[t][i][b] = 0;
+      }
+      hostSerial.println();
+    }
+  }
+  hostSerial.println(F("END"));
+#else
+  hostSerial.println(F("E: not supported"));
+#endif
+}
+
+#ifdef LOOP_PROFILER
+
+struct profileStageType {
+  uint16_t minTime;         // shortest run of the stage (in microseconds)
+  uint16_t maxTime;         // longest run of the stage (in microseconds)
+  uint32_t sumTime;         // sum of all runs, for the mean value
+  uint16_t count;           // number of runs
+};
+
+struct profileTickType {
+  uint32_t timestamp;       // millis() when the tick ended
+  uint16_t period;          // time since the previous tick (in microseconds)
+  uint8_t  stage;           // longest running stage in this period
+};
+
+const char profileStageNames[PROFILE_STAGES][9] PROGMEM = {
+  "SERIAL", "EVENTS", "BUTTONS", "MACRO", "MOUSE", "LEDS", "PREFETCH"
+};
+
+struct profileStageType profileStages[PROFILE_STAGES];
+struct profileStageType slotChanges[2];    // duration of slot changes (AT NE), decoded from EEPROM / copied from the slot cache
+struct profileTickType worstTicks[PROFILE_WORST_TICKS];
+uint32_t profileTimestamp = 0;     // micros() at the end of the last measured stage
+uint32_t tickTimestamp = 0;        // micros() at the start of the current tick
+uint16_t tickMaxTime = 0;          // longest stage run since the start of the current tick
+uint8_t  tickMaxStage = 0;         // the stage which caused tickMaxTime
+uint16_t tickCount = 0;
+uint16_t tickOverruns = 0;
+
+/**
+   @name resetLoopProfile
+   @param none
+   @return none
+
+   clears all profiler statistics
+*/
+void resetLoopProfile()
+{
+  memset(profileStages, 0, sizeof(profileStages));
+  memset(slotChanges, 0, sizeof(slotChanges));
+  memset(worstTicks, 0, sizeof(worstTicks));
+  for (uint8_t i = 0; i < PROFILE_STAGES; i++)
+    profileStages[i].minTime = 0xffff;
+  slotChanges[0].minTime = slotChanges[1].minTime = 0xffff;
+  tickCount = tickOverruns = 0;
+}
+
+/**
+   @name addProfileTime
+   @param struct profileStageType * p  the statistics
+   @param uint32_t duration  the measured time in microseconds
+   @return none
+*/
+void addProfileTime(struct profileStageType * p, uint32_t duration)
+{
+  if (duration > 0xffff) duration = 0xffff;
+  if (p->count == 0xffff) { p->count >>= 1; p->sumTime >>= 1; }   // keep a running mean
+  if (duration < p->minTime) p->minTime = duration;
+  if (duration > p->maxTime) p->maxTime = duration;
+  p->sumTime += duration;
+  p->count++;
+}
+
+/**
+   @name profileStage
+   @param uint8_t stage  the stage which just finished (PROFILE_SERIAL ... PROFILE_PREFETCH)
+   @return none
+
+   adds the time since the end of the previous stage to the statistics of the given stage
+*/
+void profileStage(uint8_t stage)
+{
+  uint32_t now = micros();
+  uint32_t duration = now - profileTimestamp;
+  profileTimestamp = now;
+  if (duration > 0xffff) duration = 0xffff;
+  addProfileTime(&profileStages[stage], duration);
+
+  if (duration > tickMaxTime) {
+    tickMaxTime = duration;
+    tickMaxStage = stage;
+  }
+}
+
+/**
+   @name profileSlotChange
+   @param uint32_t startTimestamp  micros() at the start of the slot change
+   @param uint8_t cached  1 if the slot was copied from the slot cache
+   @return none
+
+   adds the duration of a slot change (until the new slot is active and indicated) to the statistics
+*/
+void profileSlotChange(uint32_t startTimestamp, uint8_t cached)
+{
+  addProfileTime(&slotChanges[cached ? 1 : 0], micros() - startTimestamp);
+}
+
+/**
+   @name profileTick
+   @param none
+   @return none
+
+   called at the start of every tick: checks the period since the previous tick 
+   for an overrun and keeps the worst periods together with their longest stage
+*/
+void profileTick()
+{
+  uint32_t now = micros();
+  if (tickTimestamp == 0) {       // first tick after startup: no period yet
+    resetLoopProfile();
+    tickTimestamp = now;
+    return;
+  }
+
+  uint32_t period = now - tickTimestamp;
+  if (period > 0xffff) period = 0xffff;
+  tickTimestamp = now;
+  if (tickCount < 0xffff) tickCount++;
+  if ((period > DEFAULT_WAIT_TIME * 1000UL + PROFILE_TOLERANCE) && (tickOverruns < 0xffff))
+    tickOverruns++;
+
+  // replace the smallest of the worst ticks if this one took longer
+  uint8_t slot = 0;
+  for (uint8_t i = 1; i < PROFILE_WORST_TICKS; i++)
+    if (worstTicks[i].period < worstTicks[slot].period) slot = i;
+  if (period > worstTicks[slot].period) {
+    worstTicks[slot].timestamp = millis();
+    worstTicks[slot].period = period;
+    worstTicks[slot].stage = tickMaxStage;
+  }
+  tickMaxTime = 0;
+}
+
+/**
+   @name printStageName
+   @param uint8_t stage  index of the stage
+   @return none
+
+   prints the name of a profiler stage
+*/
+void printStageName(uint8_t stage)
+{
+  char name[9];
+  strcpy_P(name, profileStageNames[stage]);
+  hostSerial.print(name);
+}
+
+#endif
+
+/**
+   @name printLoopProfile
+   @param none
+   @return none
+
+   prints the loop profiler statistics and resets them:
+   min / mean / max time of every stage and of the slot changes (in microseconds,
+   slot changes from EEPROM and from the slot cache separately), the number of ticks 
+   and tick overruns and the worst tick periods with the longest stage of each
+*/
+void printLoopProfile()
+{
+#ifdef LOOP_PROFILER
+  for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+    struct profileStageType * p = &profileStages[i];
+    hostSerial.print(F("PROFILE ")); printStageName(i);
+    hostSerial.print(F(" min:")); hostSerial.print(p->count ? p->minTime : 0);
+    hostSerial.print(F(" mean:")); hostSerial.print(p->count ? p->sumTime / p->count : 0);
+    hostSerial.print(F(" max:")); hostSerial.println(p->maxTime);
+  }
+  for (uint8_t i = 0; i < 2; i++) {
+    struct profileStageType * p = &slotChanges[i];
+    hostSerial.print(i ? F("SLOTCHANGE CACHED") : F("SLOTCHANGE EEPROM"));
+    hostSerial.print(F(" count:")); hostSerial.print(p->count);
+    hostSerial.print(F(" min:")); hostSerial.print(p->count ? p->minTime : 0);
+    hostSerial.print(F(" mean:")); hostSerial.print(p->count ? p->sumTime / p->count : 0);
+    hostSerial.print(F(" max:")); hostSerial.println(p->maxTime);
+  }
+  hostSerial.print(F("TICKS:")); hostSerial.print(tickCount);
+  hostSerial.print(F(" OVERRUNS:")); hostSerial.println(tickOverruns);
+  for (uint8_t i = 0; i < PROFILE_WORST_TICKS; i++) {
+    if (!worstTicks[i].period) continue;
+    hostSerial.print(F("WORST period:")); hostSerial.print(worstTicks[i].period);
+    hostSerial.print(F(" stage:")); printStageName(worstTicks[i].stage);
+    hostSerial.print(F(" at:")); hostSerial.println(worstTicks[i].timestamp);
+  }
+  hostSerial.println(F("END"));
+  tickTimestamp = 0;     // restart the statistics with the next tick (excludes the time of this report)
+#else
+  hostSerial.println(F("E: not supported"));
+#endif
+}
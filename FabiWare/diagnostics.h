@@ -0,0 +1,58 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: diagnostics.h - latency and timing measurements, loop profiler
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+
+#ifndef _DIAGNOSTICS_H_
+#define _DIAGNOSTICS_H_
+
+#define LATENCY_USB 0
+#define LATENCY_BT  1
+
+#define LATENCY_BUCKETS      8           // histogram buckets: <1ms, <2ms, <4ms ... <64ms, >=64ms
+#define LATENCY_TIMEOUT  500000UL        // press without HID report within this time (in microseconds) is not counted
+
+#ifdef LATENCY_HISTOGRAM
+void startLatencyMeasurement(uint8_t button, uint32_t edgeTimestamp);
+void recordLatency(uint8_t transport);
+#else
+#define startLatencyMeasurement(button, edgeTimestamp)
+#define recordLatency(transport)
+#endif
+
+void printLatencyHistogram();
+
+#define PROFILE_SERIAL      0            // loop profiler stages, see loop()
+#define PROFILE_EVENTS      1
+#define PROFILE_BUTTONS     2
+#define PROFILE_MACRO       3
+#define PROFILE_MOUSE       4
+#define PROFILE_LEDS        5
+#define PROFILE_PREFETCH    6
+#define PROFILE_STAGES      7
+
+#define PROFILE_WORST_TICKS 4            // number of worst ticks which are kept
+#define PROFILE_TOLERANCE   1000UL       // tick period may exceed the wait time by this value (in microseconds) 
+
+#ifdef LOOP_PROFILER
+void profileStage(uint8_t stage);
+void profileTick();
+void profileSlotChange(uint32_t startTimestamp, uint8_t cached);
+#else
+#define profileStage(stage)
+#define profileTick()
+#define profileSlotChange(startTimestamp, cached)
+#endif
+
+void printLoopProfile();
+
+#endif
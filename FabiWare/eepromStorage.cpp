@@ -12,18 +12,89 @@
 
 */
 
+#include <util/crc16.h>
 #include "fabi.h"
 #include "eepromStorage.h"
+#include "keys.h"
 
-#define MAGIC_BYTE 42  // "magic byte" for valid EEPROM content
-#define SLOTSIZE (sizeof(settingsType)+NUMBER_OF_BUTTONS*sizeof(buttonType))
+#define MAGIC_BYTE 48  // "magic byte" for valid EEPROM content
 
+#define BUTTON_COMMAND_MASK   0x3f      // command identifier of a button (6 bits)
+#define BUTTON_COMMAND_ESCAPE 0x3f      // identifiers from 63 on: the identifier minus 63 follows in an extra byte
+#define BUTTON_HAS_VALUE      0x40      // a value follows
+#define BUTTON_HAS_KEYSTRING  0x80      // a keystring follows
 
+static_assert(NUM_SETTING_FIELDS <= 16, "the settings bitmap has 16 bits");
+static_assert(NUM_COMMANDS <= BUTTON_COMMAND_ESCAPE + 256, "command identifiers are stored in 6 bits plus an extra byte");
 
-int nextSlotAddress=0;
-int EmptySlotAddress = 0;
-int EmptyKeystringAddress=EEPROM_TOP_ADDRESS-1;
-uint16_t freeEEPROMbytes = EEPROM_TOP_ADDRESS;
+
+
+struct slotDirectoryType {         // location of a slot in the log, see buildSlotDirectory()
+  uint8_t  nameHash;               // hash of the slot name (see slotNameHash())
+  storageAddress address;          // start address of the newest record of the slot
+};
+
+struct stringEntryType {           // a keystring of the string pool, see findString()
+  storageAddress address;          // start address of the string record
+  uint8_t  len;                    // size of the string record (a keystring is shorter than MAX_CMDLEN)
+  uint8_t  refs;                   // number of buttons (of all slots) which use the string, 0: unused entry
+};
+
+#if STORAGE_SIZE > 1024            // external storage: more slots (RAM per entry: 3 bytes, 5 bytes above 32 KB)
+  #define MAX_SLOTS 40             // entries of the slot directory
+  #define MAX_STRINGS 48           // entries of the string pool, string ids are 1..MAX_STRINGS
+#else
+  #define MAX_SLOTS 24
+  #define MAX_STRINGS 32
+#endif
+#define MAX_STRING_REFS 255
+
+struct slotDirectoryType slotDirectory[MAX_SLOTS];
+uint8_t numSlots=0;
+uint8_t nextSlot=0;                // index of the slot which is loaded by readFromEEPROM(0)
+
+struct stringEntryType stringPool[MAX_STRINGS];
+uint8_t slotStringIds[NUMBER_OF_BUTTONS];   // string ids of the keystrings of the slot which is saved
+
+storageAddress logTail=0;          // address of the oldest record
+storageAddress logHead=0;          // address where the next record is written
+storageAddress logUsed=0;          // bytes from logTail to logHead (live and obsolete records)
+storageAddress liveBytes=0;        // bytes of the records in the slot directory and the string pool
+uint16_t nextSeq=0;                // sequence number of the next record
+uint16_t nextOrder=0;              // listing order of the next new slot
+
+// payload access of the record which is currently written or read (see putPayloadByte())
+storageAddress payloadAddress=0;
+storageAddress payloadPos=0;
+uint16_t payloadCrc=0;
+uint8_t  payloadCountOnly=0;       // only count the bytes (for the size of a record)
+
+// state of an EEPROM image restore (AT EI / AT EW)
+uint8_t  restoreActive = 0;
+uint8_t  restoreErased = 0;        // the log was erased because the image did not fit next to the records
+storageAddress restoreBase = 0;    // log address of the image (the head of the log at AT EI)
+uint16_t restoreRecords = 0;       // number of records of the image
+uint16_t restoreCount = 0;         // number of records received
+storageAddress restoreLength = 0;  // size of the image (all records)
+storageAddress restorePos = 0;     // number of image bytes received
+storageAddress restoreNext = 0;    // image position of the next record
+uint16_t restoreCrc = 0;           // crc of the received image bytes
+uint16_t restoreExpectedCrc = 0;   // crc from the image header
+
+#ifdef SLOT_CACHE
+#define SLOT_CACHE_EMPTY  0xff
+
+struct slotCacheType {             // a decoded slot, see prefetchNextSlot()
+  uint8_t  slot;                   // index in the slot directory, SLOT_CACHE_EMPTY: no slot
+  uint16_t keystringLen;           // bytes of the keystrings, 0: the keystrings did not fit (slot not cached)
+  struct settingsType settings;
+  struct buttonType buttons[NUMBER_OF_BUTTONS];
+  char keystrings[SLOT_CACHE_KEYSTRING_LEN];
+};
+
+struct slotCacheType slotCache = { SLOT_CACHE_EMPTY };
+#endif
+uint8_t slotCacheHit = 0;          // 1: the last slot was loaded from the slot cache
 
 
 /**
@@ -31,195 +102,832 @@ uint16_t freeEEPROMbytes = EEPROM_TOP_ADDRESS;
    @param none
    @return none
 
-   returns free EEPROM memory in percent
+   returns free EEPROM memory in percent (obsolete records count as free, they are reclaimed when needed)
 */
 uint16_t getfreeEEPROM() {
-  return ((uint32_t) freeEEPROMbytes * 100 / EEPROM_TOP_ADDRESS);
+  return ((uint32_t) (LOG_SIZE - liveBytes) * 100 / LOG_SIZE);
+}
+
+
+/**
+   @name invalidateSlotCache
+   @param none
+   @return none
+
+   removes the decoded slot from the slot cache (called when slots are saved, deleted or rebuilt)
+*/
+void invalidateSlotCache()
+{
+#ifdef SLOT_CACHE
+   slotCache.slot=SLOT_CACHE_EMPTY;
+#endif
+}
+
+
+/**
+   @name logAddress
+   @param storageAddress address  log address, up to 2*LOG_SIZE-1
+   @return storageAddress  EEPROM address (the log wraps around at LOG_SIZE)
+*/
+storageAddress logAddress(storageAddress address)
+{
+  if (address >= LOG_SIZE) address -= LOG_SIZE;
+  return (address);
+}
+
+uint8_t logRead(storageAddress address)
+{
+  return (storageRead(logAddress(address)));
+}
+
+void logWrite(storageAddress address, uint8_t b)
+{
+  storageWrite(logAddress(address), b);
 }
 
+uint16_t logReadWord(storageAddress address)
+{
+  return (logRead(address) | (logRead(address + 1) << 8));
+}
 
 /**
-   move multiple bytes in EEPROM 
-   targetAdr: start address for writing bytes 
-   sourceAdr: start address for reading bytes 
-   count: number of bytes to move
-   moving overlapping regions is possible
- * */
-void moveEEPROM(uint16_t targetAdr, uint16_t sourceAdr, int count) {
-  if (sourceAdr > targetAdr) {  // forward copy
-    while (count-- > 0) {      
-      uint8_t c=EEPROM.read(sourceAdr++);
-      EEPROM.update(targetAdr++,c);
+   @name recordLength
+   @param storageAddress address  start address of a record
+   @return storageAddress  size of the record including header and crc
+*/
+storageAddress recordLength(storageAddress address)
+{
+  return (RECORD_OVERHEAD + logReadWord(address + 2));
+}
+
+/**
+   @name checkRecord
+   @param storageAddress address  EEPROM address
+   @return storageAddress  size of the record which starts at this address, 0 if there is no valid record
+*/
+storageAddress checkRecord(storageAddress address)
+{
+  uint8_t marker = logRead(address);
+  if ((marker != RECORD_VALID) && (marker != RECORD_OBSOLETE)) return (0);
+  uint8_t type = logRead(address + 1);
+  if ((type != RECORD_SLOT) && (type != RECORD_STRING)) return (0);
+
+  storageAddress len = recordLength(address);
+  if (len > LOG_SIZE) return (0);
+
+  uint16_t crc = 0xffff;
+  for (storageAddress i = 1; i < len - 2; i++)
+    crc = _crc_ccitt_update(crc, logRead(address + i));
+  if (crc != logReadWord(address + len - 2)) return (0);
+  return (len);
+}
+
+
+/**
+   @name putPayloadByte
+   @param uint8_t b
+   @return none
+
+   appends a byte to the payload of the record which is written (see beginRecord())
+*/
+void putPayloadByte(uint8_t b)
+{
+  if (!payloadCountOnly) {
+    logWrite(payloadAddress + payloadPos, b);
+    payloadCrc = _crc_ccitt_update(payloadCrc, b);
+  }
+  payloadPos++;
+}
+
+/**
+   @name getPayloadByte
+   @param none
+   @return uint8_t  the next byte of the payload of the record which is read
+*/
+uint8_t getPayloadByte()
+{
+  return (logRead(payloadAddress + payloadPos++));
+}
+
+/**
+   @name readString
+   @param uint8_t id  string id
+   @param char * dest  buffer for the string
+   @param uint16_t size  size of the buffer
+   @return uint16_t  number of characters which were copied (at most size-1, the terminating zero is not written)
+
+   copies a keystring from the string pool (the payload of a string record is the id and the zero terminated string)
+*/
+uint16_t readString(uint8_t id, char * dest, uint16_t size)
+{
+  if ((id < 1) || (id > MAX_STRINGS) || (!stringPool[id - 1].refs)) return (0);
+  storageAddress address = stringPool[id - 1].address + RECORD_HEADER_LEN + 1;
+  uint16_t len = 0;
+  char c;
+  while ((len + 1 < size) && ((c = logRead(address + len)) != 0))
+    dest[len++] = c;
+  return (len);
+}
+
+/**
+   @name findString
+   @param const char * str  a keystring
+   @return uint8_t  id of the string in the string pool, 0 if the string is not stored
+*/
+uint8_t findString(const char * str)
+{
+  for (uint8_t id = 1; id <= MAX_STRINGS; id++) {
+    if ((!stringPool[id - 1].refs) || (stringPool[id - 1].refs == MAX_STRING_REFS)) continue;
+    storageAddress address = stringPool[id - 1].address + RECORD_HEADER_LEN + 1;
+    uint8_t c, i = 0;
+    while ((c = logRead(address + i)) == (uint8_t)str[i]) {
+      if (!c) return (id);
+      i++;
     }
   }
-  else {  // backward copy
-    sourceAdr+=count-1;
-    targetAdr+=count-1;
-    while (count--) {
-      EEPROM.update(targetAdr--,EEPROM.read(sourceAdr--));
+  return (0);
+}
+
+/**
+   @name putVarint
+   @param uint32_t value
+   @return none
+
+   appends a value to the payload, 7 bits per byte (bit 7: more bytes follow)
+*/
+void putVarint(uint32_t value)
+{
+  while (value > 0x7f) {
+    putPayloadByte((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  putPayloadByte(value);
+}
+
+/**
+   @name getVarint
+   @param none
+   @return uint32_t  the next value of the payload (see putVarint())
+*/
+uint32_t getVarint()
+{
+  uint32_t value = 0;
+  uint8_t shift = 0, b;
+  do {
+    b = getPayloadByte();
+    if (shift < 32) value |= (uint32_t)(b & 0x7f) << shift;
+    shift += 7;
+  } while (b & 0x80);
+  return (value);
+}
+
+/**
+   @name encodeSlot
+   @param none
+   @return none
+
+   writes the current settings, buttons and keystrings as record payload:
+   slot name (zero terminated), a bitmap of the settings fields which differ from
+   defaultSettings (2 bytes) followed by their values (varints), then one entry per button:
+   command identifier (bits 0-5), BUTTON_HAS_VALUE, BUTTON_HAS_KEYSTRING, the identifier minus
+   BUTTON_COMMAND_ESCAPE (1 byte, if the identifier does not fit into 6 bits),
+   the value (zigzag varint) and the string id of the keystring (see slotStringIds[]) if the flags are set
+*/
+void encodeSlot()
+{
+  const char * c = settings.slotname;     // the slot name is the first field
+  do putPayloadByte(*c); while (*c++);
+
+  uint16_t fields = 0;
+  for (uint8_t f = 0; f < NUM_SETTING_FIELDS; f++) {
+    if (memcmp((uint8_t*) &settings + pgm_read_byte_near(&settingFields[f].offset), (uint8_t*) &defaultSettings + pgm_read_byte_near(&settingFields[f].offset), pgm_read_byte_near(&settingFields[f].size)))
+      fields |= (1 << f);
+  }
+  putPayloadByte(fields & 0xff);
+  putPayloadByte(fields >> 8);
+  for (uint8_t f = 0; f < NUM_SETTING_FIELDS; f++) {
+    if (!(fields & (1 << f))) continue;
+    uint32_t value = 0;
+    uint8_t * p = (uint8_t*) &settings + pgm_read_byte_near(&settingFields[f].offset);
+    for (uint8_t i = pgm_read_byte_near(&settingFields[f].size); i > 0; i--)
+      value = (value << 8) | p[i - 1];
+    putVarint(value);
+  }
+
+  for (uint8_t i = 0; i < NUMBER_OF_BUTTONS; i++) {
+    int32_t value = buttons[i].value;
+    c = getKeystring(i);
+    uint16_t mode = buttons[i].mode;
+    putPayloadByte((mode < BUTTON_COMMAND_ESCAPE ? mode : BUTTON_COMMAND_ESCAPE) | (value ? BUTTON_HAS_VALUE : 0) | (*c ? BUTTON_HAS_KEYSTRING : 0));
+    if (mode >= BUTTON_COMMAND_ESCAPE) putPayloadByte(mode - BUTTON_COMMAND_ESCAPE);
+    if (value) putVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+    if (*c) putPayloadByte(slotStringIds[i]);
+  }
+}
+
+/**
+   @name decodeSlot
+   @param struct settingsType * dest  settings of the slot
+   @param struct buttonType * destButtons  button functions of the slot
+   @param char * keystrings  buffer for the keystrings (one zero terminated string per button)
+   @param uint16_t size  size of the keystring buffer
+   @return uint16_t  bytes of the keystrings, 0 if a keystring was cut off
+
+   reads settings, buttons and keystrings from a record payload (see encodeSlot())
+*/
+uint16_t decodeSlot(struct settingsType * dest, struct buttonType * destButtons, char * keystrings, uint16_t size)
+{
+  memcpy(dest, &defaultSettings, sizeof(struct settingsType));
+  uint8_t i = 0, complete = 1;
+  char c;
+  while ((c = getPayloadByte()) != 0)
+    if (i < MAX_SLOTNAME_LEN - 1) dest->slotname[i++] = c;
+  dest->slotname[i] = 0;
+
+  uint16_t fields = getPayloadByte();
+  fields |= getPayloadByte() << 8;
+  for (uint8_t f = 0; f < NUM_SETTING_FIELDS; f++) {
+    if (!(fields & (1 << f))) continue;
+    uint32_t value = getVarint();
+    uint8_t * p = (uint8_t*) dest + pgm_read_byte_near(&settingFields[f].offset);
+    for (uint8_t b = 0; b < pgm_read_byte_near(&settingFields[f].size); b++, value >>= 8)
+      p[b] = value & 0xff;
+  }
+
+  uint16_t pos = 0;
+  for (i = 0; i < NUMBER_OF_BUTTONS; i++) {
+    uint8_t header = getPayloadByte();
+    destButtons[i].mode = header & BUTTON_COMMAND_MASK;
+    if (destButtons[i].mode == BUTTON_COMMAND_ESCAPE) destButtons[i].mode += getPayloadByte();
+    destButtons[i].value = 0;
+    if (header & BUTTON_HAS_VALUE) {
+      uint32_t value = getVarint();
+      destButtons[i].value = (int32_t)((value >> 1) ^ (~(value & 1) + 1));
+    }
+    if (header & BUTTON_HAS_KEYSTRING) {
+      uint16_t room = size - (NUMBER_OF_BUTTONS - 1 - i) - pos;
+      uint16_t len = readString(getPayloadByte(), keystrings + pos, room);
+      if (len + 1 >= room) complete = 0;     // the string may be longer
+      pos += len;
     }
+    keystrings[pos++] = 0;
   }
+  return (complete ? pos : 0);
 }
 
+/**
+   @name encodedSlotLength
+   @param none
+   @return storageAddress  size of the record for the current slot data
+*/
+storageAddress encodedSlotLength()
+{
+  payloadCountOnly = 1;
+  payloadPos = 0;
+  encodeSlot();
+  payloadCountOnly = 0;
+  return (RECORD_OVERHEAD + payloadPos);
+}
 
 
 /**
-   @name getSlotInfos
-   @param char * slotname
-   @param uint16_t * s_address
-   @param uint16_t * k_address
-   @param uint16_t * k_len
-   @return uint8_t
+   @name beginRecord
+   @param uint8_t type  record type
+   @param storageAddress len  size of the record including header and crc
+   @param uint16_t order  listing order of the slot
+   @return storageAddress  start address of the record
 
-   get information about a slot from the EEPROM
+   writes the record header at the head of the log, the payload follows with putPayloadByte().
+   The marker stays 0 until finishRecord().
+*/
+storageAddress beginRecord(uint8_t type, storageAddress len, uint16_t order)
+{
+  uint8_t header[RECORD_HEADER_LEN] = { 0, type, (uint8_t)(len - RECORD_OVERHEAD), (uint8_t)((len - RECORD_OVERHEAD) >> 8),
+                                        (uint8_t)nextSeq, (uint8_t)(nextSeq >> 8), (uint8_t)order, (uint8_t)(order >> 8) };
 
-   returns 1 if slotname was found, and 0 if not.
-   if the slow was found, the slot address (s_address), 
-   the keystring address (k_address) and the length of the keysting (k_len) are returned.
-   Note that keystrings are stored "top-down" in EEPROM (k_address is the top address)
+  logWrite(logHead, 0);
+  payloadCrc = 0xffff;
+  for (uint8_t i = 1; i < RECORD_HEADER_LEN; i++) {
+    logWrite(logHead + i, header[i]);
+    payloadCrc = _crc_ccitt_update(payloadCrc, header[i]);
+  }
+  payloadAddress = logHead + RECORD_HEADER_LEN;
+  payloadPos = 0;
+  return (logHead);
+}
+
+/**
+   @name finishRecord
+   @param none
+   @return none
+
+   writes the crc and then the marker of the record, which makes it valid
 */
-uint8_t getSlotInfos(char * slotname, uint16_t * s_address, uint16_t * k_address, uint16_t * k_len)
+void finishRecord()
 {
-   uint16_t address=0;
-   uint16_t keystringAddress=EEPROM_TOP_ADDRESS-1;
+  storageAddress address = logHead;
+  storageAddress len = RECORD_OVERHEAD + payloadPos;
 
-   while (EEPROM.read(address))
-   {
-      uint8_t c,i=0,match=0;
-      while (c=EEPROM.read(address+i)) {
-        if (slotname[i] == c) i++;
-        else break;
-      }
-      if (!slotname[i] && !c) {
-          match=1; 
-          *s_address = address;
-          *k_address = keystringAddress;
-          *k_len=0;
-      }
-      
-      uint8_t stringCount=0; 
-      while (stringCount < NUMBER_OF_BUTTONS) {
-         if (!EEPROM.read(keystringAddress--)) stringCount++;
-         if (match) *k_len = *k_len + 1;  // increase keystring length info 
+  logWrite(payloadAddress + payloadPos, payloadCrc & 0xff);
+  logWrite(payloadAddress + payloadPos + 1, payloadCrc >> 8);
+  logWrite(address, RECORD_VALID);
+
+  logHead = logAddress(logHead + len);
+  logUsed += len;
+  nextSeq++;
+}
+
+
+/**
+   @name slotNameHash
+   @param const char * slotname
+   @return uint8_t  hash value of the slot name (for a quick compare in the slot directory)
+*/
+uint8_t slotNameHash(const char * slotname)
+{
+   uint8_t hash=0;
+   while (*slotname) hash = (hash * 33) ^ *slotname++;
+   return(hash);
+}
+
+/**
+   @name readSlotName
+   @param storageAddress address  start address of a record
+   @param char * slotname  buffer of MAX_SLOTNAME_LEN characters
+   @return none
+*/
+void readSlotName(storageAddress address, char * slotname)
+{
+   uint8_t i=0;
+   while ((i < MAX_SLOTNAME_LEN - 1) && ((slotname[i]=logRead(address+RECORD_HEADER_LEN+i)) != 0)) i++;
+   slotname[i]=0;
+}
+
+/**
+   @name findSlot
+   @param const char * slotname
+   @return int8_t  index of the slot in the slot directory, -1 if not found
+*/
+int8_t findSlot(const char * slotname)
+{
+   uint8_t hash=slotNameHash(slotname);
+
+   for (uint8_t s=0; s<numSlots; s++) {
+      if (slotDirectory[s].nameHash != hash) continue;
+
+      // compare the name stored in EEPROM
+      storageAddress address=slotDirectory[s].address+RECORD_HEADER_LEN;
+      uint8_t c,i=0;
+      while ((c=logRead(address+i)) == slotname[i]) {
+        if (!c) return(s);
+        i++;
       }
-      if (match) return(1);
+   }
+   return(-1);
+}
 
-      // skip to next slot address
-      address+=SLOTSIZE;
+/**
+   @name markObsolete
+   @param uint8_t s  index of the slot in the slot directory
+   @return none
+
+   marks the record of a slot obsolete, its space is reclaimed by the next compaction
+*/
+void markObsolete(uint8_t s)
+{
+   storageAddress address=slotDirectory[s].address;
+   liveBytes-=recordLength(address);
+   logWrite(address, RECORD_OBSOLETE);
+}
+
+/**
+   @name writeString
+   @param const char * str  a keystring
+   @return uint8_t  id of the new string record
+
+   appends a string record to the log (ensureSpace() must have been called) and
+   adds it to the string pool with one reference
+*/
+uint8_t writeString(const char * str)
+{
+   uint8_t id=1;
+   while (stringPool[id-1].refs) id++;
+
+   storageAddress len=RECORD_OVERHEAD + 1 + strlen(str) + 1;
+   stringPool[id-1].address=beginRecord(RECORD_STRING, len, 0);
+   putPayloadByte(id);
+   do putPayloadByte(*str); while (*str++);
+   finishRecord();
+   stringPool[id-1].len=len;
+   stringPool[id-1].refs=1;
+   liveBytes+=len;
+   return(id);
+}
+
+/**
+   @name releaseString
+   @param uint8_t id  string id
+   @return none
+
+   removes one reference of a string, the string record becomes obsolete with the last one
+*/
+void releaseString(uint8_t id)
+{
+   if ((id < 1) || (id > MAX_STRINGS) || (!stringPool[id-1].refs)) return;
+   if (--stringPool[id-1].refs) return;
+   liveBytes-=stringPool[id-1].len;
+   logWrite(stringPool[id-1].address, RECORD_OBSOLETE);
+}
+
+/**
+   @name readStringIds
+   @param storageAddress address  start address of a slot record
+   @param uint8_t * ids  string ids of the keystrings of the buttons (0: no keystring)
+   @return none
+*/
+void readStringIds(storageAddress address, uint8_t * ids)
+{
+   payloadAddress=address+RECORD_HEADER_LEN;
+   payloadPos=0;
+   while (getPayloadByte());                   // slot name
+   uint16_t fields=getPayloadByte();
+   fields|=getPayloadByte() << 8;
+   for (uint8_t f=0; f<NUM_SETTING_FIELDS; f++)
+     if (fields & (1 << f)) getVarint();
+
+   for (uint8_t i=0; i<NUMBER_OF_BUTTONS; i++) {
+     uint8_t header=getPayloadByte();
+     if ((header & BUTTON_COMMAND_MASK) == BUTTON_COMMAND_ESCAPE) getPayloadByte();
+     if (header & BUTTON_HAS_VALUE) getVarint();
+     ids[i]=(header & BUTTON_HAS_KEYSTRING) ? getPayloadByte() : 0;
    }
-   return(0);
 }
 
+/**
+   @name referenceStringIds
+   @param const uint8_t * ids  string ids of the keystrings of a slot (see readStringIds())
+   @param uint8_t add  1: add a reference to the keystrings, 0: release them
+   @return none
+*/
+void referenceStringIds(const uint8_t * ids, uint8_t add)
+{
+   for (uint8_t i=0; i<NUMBER_OF_BUTTONS; i++) {
+     uint8_t id=ids[i];
+     if (!id) continue;
+     if (!add) releaseString(id);
+     else if ((id <= MAX_STRINGS) && (stringPool[id-1].refs) && (stringPool[id-1].refs < MAX_STRING_REFS))
+       stringPool[id-1].refs++;
+   }
+}
 
 /**
-   @name saveToEEPROM
-   @param char * slotname
-   @return 1:success/0:fail
+   @name referenceStrings
+   @param storageAddress address  start address of a slot record
+   @param uint8_t add  1: add a reference to the keystrings of the slot, 0: release them
+   @return none
+*/
+void referenceStrings(storageAddress address, uint8_t add)
+{
+   uint8_t ids[NUMBER_OF_BUTTONS];
+   readStringIds(address, ids);
+   referenceStringIds(ids, add);
+}
 
-   saves the configuration slot (identified by slotname) to the EEPROM
-   cancels if not enough EEPROM memory free
-   returns 0 if EEPROM memory is full / 1 if save was successful
-   
+/**
+   @name eraseLog
+   @param none
+   @return none
+
+   removes all records (only the markers are cleared)
 */
-uint8_t saveToEEPROM(char * slotname)
+void eraseLog()
+{
+   for (storageAddress address=0; address<LOG_SIZE; address++) {
+     uint8_t marker=storageRead(address);
+     if ((marker==RECORD_VALID) || (marker==RECORD_OBSOLETE))
+       storageWrite(address,0);
+   }
+   logTail=logHead=logUsed=liveBytes=0;
+   numSlots=0;
+   nextSlot=0;
+   nextOrder=0;
+   memset(stringPool,0,sizeof(stringPool));
+   invalidateSlotCache();
+}
+
+/**
+   @name buildSlotDirectory
+   @param none
+   @return none
+
+   finds the log in EEPROM, builds the slot directory, the string pool 
+   and the free memory bookkeeping. Strings which are not used by any slot
+   (e.g. after an interrupted save) are marked obsolete.
+*/
+void buildSlotDirectory()
 {
    char act_slotname[MAX_SLOTNAME_LEN];
-   int delta=0;
-   uint16_t address=0;
-   uint16_t keystring_address;
-   uint16_t old_keystring_len, keystring_len;
-   uint8_t append=0;
-   uint8_t * p;
+   uint8_t found=0;
 
+   // the oldest valid record is the start of the log
+   for (storageAddress address=0; address<LOG_SIZE; address++) {
+     if (!checkRecord(address)) continue;
+     uint16_t seq=logReadWord(address+4);
+     if ((!found) || ((int16_t)(seq-nextSeq) < 0)) {
+       logTail=address;
+       nextSeq=seq;
+     }
+     found=1;
+   }
 
-   keystring_len=keystringMemUsage(0);  // lenght of current keystrings
+   // follow the log while the records are valid and newer than the previous one
+   numSlots=0;
+   logUsed=liveBytes=0;
+   memset(stringPool,0,sizeof(stringPool));
+   if (!found) logTail=0;
+   storageAddress address=logTail;
+   storageAddress len;
+   while ((logUsed < LOG_SIZE) && ((len=checkRecord(address)) != 0) && (logUsed+len <= LOG_SIZE)) {
+     uint16_t seq=logReadWord(address+4);
+     if ((logUsed) && ((int16_t)(seq-nextSeq) < 0)) break;
+     nextSeq=seq+1;
 
-   if (getSlotInfos(slotname, &address, &keystring_address, &old_keystring_len)) {
-     #ifdef DEBUG_OUTPUT   
-       Serial.println("Slot already exists !!");
-       Serial.print(F(" starting from EEPROM address ")); Serial.println(address);
-       Serial.print(F(" keystring address ")); Serial.println(keystring_address);
-       Serial.print(F(" old keystring length ")); Serial.print(old_keystring_len);
-       Serial.print(F(", act len: ")); Serial.println(keystring_len);
-     #endif
+     if ((logRead(address)==RECORD_VALID) && (logRead(address+1)==RECORD_STRING)) {
+       uint8_t id=logRead(address+RECORD_HEADER_LEN);
+       if ((id >= 1) && (id <= MAX_STRINGS)) {
+         struct stringEntryType * str=&stringPool[id-1];
+         if (str->refs) {              // interrupted compaction: the newer record wins
+           liveBytes-=str->len;
+           logWrite(str->address, RECORD_OBSOLETE);
+         }
+         str->address=address;
+         str->len=len;
+         str->refs=1;                  // until the references of the slots are counted
+         liveBytes+=len;
+       }
+     }
+     else if (logRead(address)==RECORD_VALID) {
+       readSlotName(address,act_slotname);
+       int8_t s=findSlot(act_slotname);
+       if (s >= 0) markObsolete(s);    // interrupted save or compaction: the newer record wins
+       else if (numSlots < MAX_SLOTS) s=numSlots++;
+       if (s >= 0) {
+         slotDirectory[s].nameHash=slotNameHash(act_slotname);
+         slotDirectory[s].address=address;
+         liveBytes+=len;
+       }
+     }
+     logUsed+=len;
+     address=logAddress(address+len);
+   }
+   logHead=address;
 
-     delta = old_keystring_len - keystring_len;
-     if (delta) {  
+   // count the references to the strings
+   for (uint8_t s=0; s<numSlots; s++)
+     referenceStrings(slotDirectory[s].address, 1);
+   for (uint8_t id=1; id<=MAX_STRINGS; id++)
+     releaseString(id);
 
-       //  move slot data?
-       #ifdef DEBUG_OUTPUT   
-         Serial.print(F(" move from address ")); Serial.print(EmptyKeystringAddress);
-         Serial.print(F(" to address ")); Serial.println(EmptyKeystringAddress+delta);
-         Serial.print(F(" bytes: ")); Serial.println(keystring_address - old_keystring_len - EmptyKeystringAddress);
-       #endif
-       
-       if (-delta > (int)freeEEPROMbytes) 
-         return 0;
-         
-       moveEEPROM (EmptyKeystringAddress+delta+1, EmptyKeystringAddress+1, keystring_address - old_keystring_len - EmptyKeystringAddress);
-       EmptyKeystringAddress+=delta;
+   // the slots are listed in the order of their first save
+   for (uint8_t i=1; i<numSlots; i++) {
+     struct slotDirectoryType slot=slotDirectory[i];
+     uint16_t order=logReadWord(slot.address+6);
+     uint8_t j=i;
+     while ((j > 0) && (logReadWord(slotDirectory[j-1].address+6) > order)) {
+       slotDirectory[j]=slotDirectory[j-1];
+       j--;
      }
+     slotDirectory[j]=slot;
    }
-   else {
-    // start with new slot
-    if ( SLOTSIZE + keystring_len > freeEEPROMbytes) 
-       return 0;
+   nextOrder=numSlots ? logReadWord(slotDirectory[numSlots-1].address+6)+1 : 0;
+   if (nextSlot >= numSlots) nextSlot=0;
+   invalidateSlotCache();
 
-    address=EmptySlotAddress;
-    keystring_address=EmptyKeystringAddress;
-    append=1;
-  }
+   #ifdef DEBUG_OUTPUT   
+       hostSerial.print(numSlots); hostSerial.print(F(" slots were found in EEPROM, occupying "));
+       hostSerial.print(liveBytes); hostSerial.print(F(" bytes (log: "));
+       hostSerial.print(logUsed); hostSerial.print(F(" bytes from address ")); hostSerial.print(logTail);
+       hostSerial.println(F(")"));
+       hostSerial.print(LOG_SIZE-liveBytes); hostSerial.println(F(" bytes are free.")); 
+   #endif
+}
+
+/**
+   @name ensureSpace
+   @param storageAddress len  size of the records which will be written
+   @param storageAddress largest  size of the largest of these records
+   @return uint8_t  1 if the records fit at the head of the log, 0 if the EEPROM is full
+
+   reclaims the oldest records until the new records fit. Live records are copied 
+   to the head of the log before their space is reused. One record size is kept 
+   in reserve, so that live records can always be copied by the next compaction.
+*/
+uint8_t ensureSpace(storageAddress len, storageAddress largest)
+{
+   storageAddress reserve=largest;
+   for (uint8_t s=0; s<numSlots; s++) {
+     storageAddress l=recordLength(slotDirectory[s].address);
+     if (l > reserve) reserve=l;
+   }
+   for (uint8_t id=1; id<=MAX_STRINGS; id++) {
+     if (!stringPool[id-1].refs) continue;
+     if (stringPool[id-1].len > reserve) reserve=stringPool[id-1].len;
+   }
+   if ((uint32_t)liveBytes + len + reserve > LOG_SIZE) return(0);
+
+   while (LOG_SIZE - logUsed < len + reserve) {
+     storageAddress address=logTail;
+     storageAddress tailLen=recordLength(address);
+
+     if (logRead(address)==RECORD_VALID) {
+       storageAddress * live=0;        // the reference to the record, if it is live
+       if (logRead(address+1)==RECORD_STRING) {
+         uint8_t id=logRead(address+RECORD_HEADER_LEN);
+         if ((id >= 1) && (id <= MAX_STRINGS) && (stringPool[id-1].refs) && (stringPool[id-1].address==address))
+           live=&stringPool[id-1].address;
+       }
+       else for (uint8_t i=0; i<numSlots; i++)
+         if (slotDirectory[i].address==address) live=&slotDirectory[i].address;
+
+       if (live) {
+         if (LOG_SIZE - logUsed < tailLen) return(0);
+         #ifdef DEBUG_OUTPUT   
+           hostSerial.print(F("moving record from address ")); hostSerial.print(address);
+           hostSerial.print(F(" to address ")); hostSerial.println(logHead);
+         #endif
+         *live=beginRecord(logRead(address+1), tailLen, logReadWord(address+6));
+         for (storageAddress i=RECORD_HEADER_LEN; i<tailLen-2; i++)
+           putPayloadByte(logRead(address+i));
+         finishRecord();
+       }
+     }
+     logWrite(address, 0);
+     logTail=logAddress(address+tailLen);
+     logUsed-=tailLen;
+   }
+   return(1);
+}
 
+
+/**
+   @name saveToEEPROM
+   @param const char * slotname
+   @return 1:success/0:fail
+
+   saves the configuration slot (identified by slotname) to the EEPROM:
+   a new record is appended to the log, the previous record of the slot becomes obsolete.
+   returns 0 if EEPROM memory is full / 1 if save was successful
    
+*/
+uint8_t saveToEEPROM(const char * slotname)
+{
+   char oldSlotname[MAX_SLOTNAME_LEN];
+
+   restoreActive=0;                   // the image of a pending restore would be overwritten
+   if (!slotname) slotname="";
+   int8_t s=findSlot(slotname);
+   if ((s < 0) && (numSlots >= MAX_SLOTS))
+     return 0;
+
+   // update slotname
+   strcpy(oldSlotname,settings.slotname);
+   strcpy(settings.slotname,slotname);
+
+   // everything which is needed from the EEPROM is read before the first byte is queued:
+   // a read has to wait for the write in progress (see eepromRead())
+   uint8_t oldStringIds[NUMBER_OF_BUTTONS];
+   storageAddress oldLen=0;
+   uint16_t order=nextOrder;
+   if (s >= 0) {
+     readStringIds(slotDirectory[s].address, oldStringIds);
+     oldLen=recordLength(slotDirectory[s].address);
+     order=logReadWord(slotDirectory[s].address+6);
+   }
+
+   // keystrings which are not in the string pool yet need a new string record
+   storageAddress len=encodedSlotLength();
+   storageAddress newBytes=len, largest=len;
+   uint8_t newStrings=0, freeIds=0;
+   for (uint8_t id=1; id<=MAX_STRINGS; id++)
+     if (!stringPool[id-1].refs) freeIds++;
+   for (uint8_t i=0; i<NUMBER_OF_BUTTONS; i++) {
+     const char * str=getKeystring(i);
+     slotStringIds[i]=*str ? findString(str) : 0;
+     if ((!*str) || (slotStringIds[i])) continue;
+     uint8_t j=0;
+     while (strcmp(getKeystring(j),str)) j++;
+     if (j < i) continue;              // the same keystring is used by a previous button
+     storageAddress l=RECORD_OVERHEAD + 1 + strlen(str) + 1;
+     newBytes+=l;
+     if (l > largest) largest=l;
+     newStrings++;
+   }
+   if ((newStrings > freeIds) || (!ensureSpace(newBytes, largest))) {
+     strcpy(settings.slotname,oldSlotname);
+     return 0;
+   }
+
    #ifdef DEBUG_OUTPUT   
-     Serial.print(F("Writing slot ")); if (slotname) Serial.print(slotname);
-     Serial.print(F(" starting from EEPROM address ")); Serial.println(address);
-     Serial.print(F("We need ")); Serial.print(SLOTSIZE);
-     Serial.print(F(" bytes for the config and ")); Serial.print(keystring_len);
-     Serial.println(F(" bytes for keystrings."));
-
-     Serial.print(freeEEPROMbytes);
-     Serial.println(F(" bytes are free.")); 
+     hostSerial.print(F("Writing slot ")); hostSerial.print(slotname);
+     hostSerial.print(F(" starting from EEPROM address ")); hostSerial.print(logHead);
+     hostSerial.print(F(", record size ")); hostSerial.print(len);
+     hostSerial.print(F(", new strings ")); hostSerial.println(newStrings);
    #endif
 
- 
-   // update slotname
-   if (!slotname) settings.slotname[0]=0;
-   else strcpy(settings.slotname,slotname);
-      
-   // write general settings 
-   p = (uint8_t*) &settings;
-   for (int t=0;t<sizeof(settingsType);t++)
-      EEPROM.update(address++,*p++);
-
-   // write all buttons
-   p = (uint8_t*) buttons;
-   for (int i=0;i<NUMBER_OF_BUTTONS*sizeof(buttonType);i++)
-        EEPROM.update(address++,*p++);
-   
-   // write keystrings
-   // Note that the keystrings are stored "top down", starting at the highest EEPROM adress
-   for (int i=0;i<keystring_len;i++)
-        EEPROM.update(keystring_address--,keystringBuffer[i]);
-
-   // update free bytes
-   if (append) {
-     EEPROM.update(address,0);
-     EmptySlotAddress=address;
-     EmptyKeystringAddress-=keystring_len;
+   // the references of the new slot are added before the old ones are released,
+   // so that shared strings are kept
+   for (uint8_t i=0; i<NUMBER_OF_BUTTONS; i++) {
+     const char * str=getKeystring(i);
+     uint8_t id=slotStringIds[i];
+     if ((*str) && (!id)) {
+       uint8_t j=0;
+       while (strcmp(getKeystring(j),str)) j++;
+       if (j < i) id=slotStringIds[j];     // written for a previous button
+     }
+     if ((id) && (stringPool[id-1].refs < MAX_STRING_REFS)) stringPool[id-1].refs++;
+     else if (*str) id=writeString(str);
+     slotStringIds[i]=id;
    }
-   
-   freeEEPROMbytes=EmptyKeystringAddress-EmptySlotAddress;
+
+   storageAddress address=beginRecord(RECORD_SLOT, len, order);
+   encodeSlot();
+   finishRecord();
+
+   if (s >= 0) {
+     referenceStringIds(oldStringIds, 0);
+     liveBytes-=oldLen;                  // see markObsolete(), without reading the record again
+     logWrite(slotDirectory[s].address, RECORD_OBSOLETE);
+   }
+   else {
+     s=numSlots++;
+     nextOrder++;
+     slotDirectory[s].nameHash=slotNameHash(slotname);
+   }
+   slotDirectory[s].address=address;
+   liveBytes+=len;
+   invalidateSlotCache();
+   storageSync();
    return(1);
 }
 
 
+/**
+   @name prefetchNextSlot
+   @param none
+   @return none
+
+   decodes the slot which is loaded by the next AT NE into the slot cache, 
+   so that the slot change only copies it (called from the main loop).
+   A slot is decoded once, also if its keystrings do not fit into the cache.
+*/
+void prefetchNextSlot()
+{
+#ifdef SLOT_CACHE
+   if ((!numSlots) || (slotCache.slot==nextSlot)) return;
+   payloadAddress=slotDirectory[nextSlot].address+RECORD_HEADER_LEN;
+   payloadPos=0;
+   slotCache.keystringLen=decodeSlot(&slotCache.settings, slotCache.buttons, slotCache.keystrings, SLOT_CACHE_KEYSTRING_LEN);
+   slotCache.slot=nextSlot;
+#endif
+}
+
+/**
+   @name loadSlotData
+   @param uint8_t s  index of the slot in the slot directory
+   @return none
+
+   loads settings, buttons and keystrings of a slot from the slot cache or the EEPROM
+   (only the record of this slot is read)
+*/
+void loadSlotData(uint8_t s)
+{
+   slotCacheHit=0;
+#ifdef SLOT_CACHE
+   if ((slotCache.slot==s) && (slotCache.keystringLen)) {
+     memcpy(&settings, &slotCache.settings, sizeof(struct settingsType));
+     memcpy(buttons, slotCache.buttons, sizeof(slotCache.buttons));
+     memcpy(keystringBuffer, slotCache.keystrings, slotCache.keystringLen);
+     slotCacheHit=1;
+   }
+#endif
+   if (!slotCacheHit) {
+     payloadAddress=slotDirectory[s].address+RECORD_HEADER_LEN;
+     payloadPos=0;
+     decodeSlot(&settings, buttons, keystringBuffer, KEYSTRING_BUFFER_LEN);
+   }
+   indexKeystrings();
+
+   actSlot=s+1; 
+   nextSlot=(s+1 < numSlots) ? s+1 : 0;
+}
+
 /**
    @name readFromEEPROM
-   @param char * slotname
+   @param const char * slotname
    @return 1:success/0:fail
 
    loads the configuration slot (identified by slotname) from the EEPROM
+   if slotname is 0, the next slot is loaded (wrap around after the last slot)
 
    in case reportSlotParameters==REPORT_ONE_SLOT, the slot configuration is printed (if slotname is found)
    in case reportSlotParameters==REPORT_ALL_SLOTS, all slot configurations are printed
@@ -227,102 +935,33 @@ uint8_t saveToEEPROM(char * slotname)
    returns 1 if slot data was loaded and/or printed, 0 if slotname was not found
    
 */
-uint8_t readFromEEPROM(char * slotname)
+uint8_t readFromEEPROM(const char * slotname)
 {
-   char slotname_copy[MAX_SLOTNAME_LEN];
-   char act_slotname[MAX_SLOTNAME_LEN];
-   int address=0;
-   int tmpSlotAddress=0;
-   int tmpStartAddress=0;
-   int tmpKeystringAddress=EEPROM_TOP_ADDRESS-1;
    uint8_t done=0;
-   uint8_t numSlots=0;
-   uint8_t stringCount=0;
-   uint8_t* p;
-
-   if (slotname) strcpy(slotname_copy,slotname);   // use a local copy of slotname
-                                     // (could be overwritten by keystring-update)!
 
-   // iterate over all valid slots in EEPROM
-   while (EEPROM.read(address)) 
-   {
-      uint8_t found=0;
-      
-      if ((!slotname) && (address==nextSlotAddress)) found=1;
-
-      tmpStartAddress=address;
-      uint8_t i=0;
-      while ((act_slotname[i++]=EEPROM.read(address++)) != 0) ; 
-      
-      #ifdef DEBUG_OUTPUT   
-         Serial.print(F("processing slot ")); Serial.println(act_slotname);
-      #endif
-
-      // if slotname matches the slot stored in EEPROM
-      if (slotname)  {
-        if (!strcmp(act_slotname, slotname_copy)) { found=1; done=1; }
-      }
-      
-      address=tmpStartAddress;
-      if ((found) || (reportSlotParameters==REPORT_ALL_SLOTS))  {       
-        #ifdef DEBUG_OUTPUT  
-           Serial.print(F("LOADING slot ")); Serial.println(act_slotname);
-        #endif
- 
-        // load settings structure
-        p = (uint8_t*) &settings;
-        for (int t=0;t<sizeof(settingsType);t++)
-            *p++=EEPROM.read(address++);
-        
-        // load button array
-        p = (uint8_t*) buttons;
-        for (int i=0;i<NUMBER_OF_BUTTONS*sizeof(buttonType);i++) 
-           *p++=EEPROM.read(address++);
-           
-        // load keystrings
-        // Note that the keystrings are stored "top down", starting at the highest EEPROM adress
-        p = (uint8_t*) keystringBuffer;
-        stringCount=0;
-        do {
-           uint8_t c=EEPROM.read(tmpKeystringAddress--);
-           *p++=c; 
-           if (!c) stringCount++;
-        } while (stringCount < NUMBER_OF_BUTTONS);
-
-        if (reportSlotParameters!=REPORT_NONE)  
-          printCurrentSlot();
-
-        actSlot=numSlots+1; 
-        tmpSlotAddress=address;
-      } 
-      else {
-        address += SLOTSIZE;   // skip this slot  
-        stringCount=0;
-        do {
-           if (!EEPROM.read(tmpKeystringAddress--)) stringCount++;
-        } while (stringCount < NUMBER_OF_BUTTONS);
-      }
-      numSlots++;
+   if (reportSlotParameters==REPORT_ALL_SLOTS) {
+     if (slotname) done=(findSlot(slotname) >= 0);
+     for (uint8_t s=0; s<numSlots; s++) {
+       loadSlotData(s);
+       printCurrentSlot();
+     }
    }
-
-   // update top address (for storing a new slot) and free bytes
-   EmptySlotAddress=address;
-   if (tmpSlotAddress) nextSlotAddress=tmpSlotAddress;
-   if (nextSlotAddress==EmptySlotAddress) nextSlotAddress=0;
-   EmptyKeystringAddress=tmpKeystringAddress;
-
-   freeEEPROMbytes=EmptyKeystringAddress-EmptySlotAddress;
-   
-   #ifdef DEBUG_OUTPUT   
-       Serial.print(numSlots); Serial.print(F(" slots were found in EEPROM, occupying "));
-       Serial.print(address+ EEPROM_TOP_ADDRESS-1-tmpKeystringAddress); Serial.print(F(" bytes ("));
-       Serial.print(F("config: ")); Serial.print(address); Serial.print(F(", keystrings: "));
-       Serial.print(EEPROM_TOP_ADDRESS-1-tmpKeystringAddress); Serial.println(F(")"));
-       Serial.print(freeEEPROMbytes); Serial.println(F(" bytes are free.")); 
-   #endif
+   else {
+     int8_t s = slotname ? findSlot(slotname) : (numSlots ? nextSlot : -1);
+     if (s >= 0) {
+       #ifdef DEBUG_OUTPUT  
+          hostSerial.print(F("LOADING slot ")); hostSerial.println(s+1);
+       #endif
+       loadSlotData(s);
+       if (reportSlotParameters!=REPORT_NONE)  
+         printCurrentSlot();
+       if (slotname) done=1;
+     }
+   }
+   compileKeyActions();     // resolve the keystrings of the loaded slot
    
    if (reportSlotParameters) {
-     Serial.println(F("END"));   // important: end marker for slot parameter list (command "load all" - AT LA)
+     hostSerial.println(F("END"));   // important: end marker for slot parameter list (command "load all" - AT LA)
      return(1);
    }
 
@@ -336,55 +975,68 @@ uint8_t readFromEEPROM(char * slotname)
 
    deletes one slot and it's keystring from the EEPROM
    if slotname is empty: deletes all slots and keystrings from EEPROM
-   setting the first valid indicators to 0
+   (the records are marked obsolete, strings when their last reference is removed)
    returns 0 if slotname was not found, 1 if slot(s) were deleted successfully
 */
-uint8_t deleteSlots(char * slotname)
+uint8_t deleteSlots(const char * slotname)
 {
    if (!strlen(slotname)) {
-    Serial.println("deleting all slots!");
-    EmptySlotAddress=0;
-    EmptyKeystringAddress=EEPROM_TOP_ADDRESS-1;
-    freeEEPROMbytes=EEPROM_TOP_ADDRESS-1;
-    nextSlotAddress=0;
-    EEPROM.update(0,0);
+    hostSerial.println("deleting all slots!");
+    for (uint8_t s=0; s<numSlots; s++) {
+      referenceStrings(slotDirectory[s].address, 0);
+      markObsolete(s);
+    }
+    numSlots=0;
+    nextSlot=0;
+    nextOrder=0;
+    invalidateSlotCache();
+    storageSync();
     return 1;
    }
    
-   uint16_t address=0, old_keystring_len, keystring_address, keystring_len;
-
-   if (getSlotInfos(slotname, &address, &keystring_address, &old_keystring_len)) {
+   int8_t s=findSlot(slotname);
+   if (s >= 0) {
      #ifdef DEBUG_OUTPUT   
-       Serial.print("deleting one slot @address "); Serial.println(address);    
-       Serial.print(" keystring length = "); Serial.println(old_keystring_len);    
+       hostSerial.print("deleting one slot @address "); hostSerial.println(slotDirectory[s].address);    
      #endif
+     referenceStrings(slotDirectory[s].address, 0);
+     markObsolete(s);
 
-     moveEEPROM (address, address+SLOTSIZE, EmptySlotAddress-address);
-     moveEEPROM (EmptyKeystringAddress+old_keystring_len+1, EmptyKeystringAddress+1 , keystring_address - old_keystring_len - EmptyKeystringAddress);
-
-     EmptySlotAddress-=SLOTSIZE;
-     EEPROM.update(EmptySlotAddress,0);
-     EmptyKeystringAddress+=old_keystring_len;
-     #ifdef DEBUG_OUTPUT   
-       Serial.print("EmptySlotAddress "); Serial.println(EmptySlotAddress);    
-       Serial.print("EmptyKeystringAddress "); Serial.println(EmptyKeystringAddress);    
-     #endif
+     // remove the slot from the directory, the following slots moved down
+     numSlots--;
+     for (uint8_t i=s; i<numSlots; i++)
+       slotDirectory[i]=slotDirectory[i+1];
+     if (nextSlot > s) nextSlot--;
+     if (nextSlot >= numSlots) nextSlot=0;
+     invalidateSlotCache();
+     storageSync();
      return(1);
    }  
    return(0);
 }
 
+/**
+   @name bootstrapEEPROM
+   @param none
+   @return none
+
+   initializes the EEPROM (if it has no valid content) and builds the slot directory
+*/
 void bootstrapEEPROM()
 {
-  if (EEPROM.read(EEPROM_TOP_ADDRESS) != MAGIC_BYTE)
+  storageInit();
+  if (storageRead(EEPROM_TOP_ADDRESS) != MAGIC_BYTE)
   {
     #ifdef DEBUG_OUTPUT   
-      Serial.println("initializing EEPROM");
+      hostSerial.println("initializing EEPROM");
     #endif
-    EEPROM.update(EEPROM_TOP_ADDRESS, MAGIC_BYTE);
-    EEPROM.update(0,0);
+    eraseLog();
+    storageWrite(EEPROM_TOP_ADDRESS, MAGIC_BYTE);
+    buildSlotDirectory();
     saveToEEPROM("default");
   }
+  else buildSlotDirectory();
+  storageSync();
 }
 
 
@@ -397,19 +1049,182 @@ void bootstrapEEPROM()
 */
 void listSlots()
 {
-   int address=0,tmpStartAddress=0;
-   uint8_t numSlots=0;
-   uint8_t b;
+   char act_slotname[MAX_SLOTNAME_LEN];
    
-   while (EEPROM.read(address))  
+   for (uint8_t s=0; s<numSlots; s++)
    {
-     numSlots++;
-     tmpStartAddress=address;
-     Serial.print(F("Slot")); Serial.print(numSlots); Serial.print(":"); 
-     while ((b=EEPROM.read(address++)) != 0)   // print slot name
-         Serial.write(b);
-     Serial.println();
-     
-     address=tmpStartAddress+SLOTSIZE;         
+     readSlotName(slotDirectory[s].address,act_slotname);
+     hostSerial.print(F("Slot")); hostSerial.print(s+1); hostSerial.print(":"); 
+     hostSerial.println(act_slotname);
    }
 }
+
+
+/**
+   @name dumpEEPROM
+   @param none
+   @return none
+
+   prints the records of all slots and strings (in the order of the log) as image which can be 
+   written back by sending the printed lines:
+   "AT EI" with the image header (magic byte, image length, number of records, crc), then
+   "AT EW" lines with EEPROM_IMAGE_CHUNK bytes each, all as hex digits, followed by "END"
+*/
+void dumpEEPROM()
+{
+  uint16_t crc = 0xffff;
+  uint16_t records = 0;
+  storageAddress imageLength = 0;   // from the same records as the dump below (not liveBytes)
+  uint8_t header[EEPROM_IMAGE_HEADER_LEN];
+
+  for (storageAddress address = logTail, used = 0; used < logUsed; ) {
+    storageAddress len = recordLength(address);
+    if (logRead(address) == RECORD_VALID) {
+      records++;
+      imageLength += len;
+      for (storageAddress i = 0; i < len; i++)
+        crc = _crc_ccitt_update(crc, logRead(address + i));
+    }
+    used += len;
+    address = logAddress(address + len);
+  }
+
+  header[0] = MAGIC_BYTE;
+  header[1] = imageLength & 0xff;  header[2] = imageLength >> 8;
+  header[3] = records & 0xff;  header[4] = records >> 8;
+  header[5] = crc & 0xff;  header[6] = crc >> 8;
+
+  hostSerial.print(F("AT EI "));
+  for (uint8_t i = 0; i < EEPROM_IMAGE_HEADER_LEN; i++) {
+    if (header[i] < 16) hostSerial.print('0');
+    hostSerial.print(header[i], HEX);
+  }
+  storageAddress pos = 0;
+  for (storageAddress address = logTail, used = 0; used < logUsed; ) {
+    storageAddress len = recordLength(address);
+    if (logRead(address) == RECORD_VALID) {
+      for (storageAddress i = 0; i < len; i++, pos++) {
+        if (!(pos % EEPROM_IMAGE_CHUNK)) { hostSerial.println(); hostSerial.print(F("AT EW ")); }
+        uint8_t b = logRead(address + i);
+        if (b < 16) hostSerial.print('0');
+        hostSerial.print(b, HEX);
+      }
+    }
+    used += len;
+    address = logAddress(address + len);
+  }
+  hostSerial.println();
+  hostSerial.println(F("END"));
+}
+
+/**
+   @name abortRestore
+   @param none
+   @return uint8_t  RESTORE_ERROR
+
+   ends a failed restore: the slots are kept, as the image was written to the free space of the log.
+   If the log had to be erased, the current settings are saved as slot "default".
+*/
+uint8_t abortRestore()
+{
+  restoreActive = 0;
+  if (restoreErased) saveToEEPROM("default");
+  return (RESTORE_ERROR);
+}
+
+/**
+   @name beginRestoreEEPROM
+   @param const uint8_t * header  the image header (see dumpEEPROM())
+   @param uint8_t len  length of the header
+   @return uint8_t  RESTORE_PENDING or RESTORE_ERROR
+
+   starts writing an EEPROM image. The image is written behind the head of the log 
+   (old records are reclaimed if necessary), so the slots stay valid until the image 
+   is verified. Only if the image does not fit next to the live records, the log is erased.
+*/
+uint8_t beginRestoreEEPROM(const uint8_t * header, uint8_t len)
+{
+  if (restoreActive) abortRestore();
+  if ((len != EEPROM_IMAGE_HEADER_LEN) || (header[0] != MAGIC_BYTE)) return (RESTORE_ERROR);
+
+  restoreLength = (uint16_t) (header[1] | (header[2] << 8));
+  restoreRecords = header[3] | (header[4] << 8);
+  restoreExpectedCrc = header[5] | (header[6] << 8);
+  if (restoreLength > LOG_SIZE) return (RESTORE_ERROR);
+
+  restoreErased = !ensureSpace(restoreLength, 0);
+  if (restoreErased) eraseLog();
+  restoreBase = logHead;
+  restorePos = 0;
+  restoreNext = 0;
+  restoreCount = 0;
+  restoreCrc = 0xffff;
+  restoreActive = 1;
+  storageSync();
+  return (RESTORE_PENDING);
+}
+
+/**
+   @name restoreEEPROM
+   @param const uint8_t * data  the next bytes of the image
+   @param int16_t len  number of bytes, a negative value aborts the restore
+   @return uint8_t  RESTORE_PENDING, RESTORE_DONE or RESTORE_ERROR
+
+   writes the next part of an EEPROM image: the records are written behind the head 
+   of the log, with cleared markers. After the last byte, the written data is read back 
+   and verified against the crc of the image header. Only then the records of the old log 
+   are cleared and the markers of the image are written, which makes its records valid, 
+   and the slot directory is rebuilt by reading the EEPROM.
+*/
+uint8_t restoreEEPROM(const uint8_t * data, int16_t len)
+{
+  if (!restoreActive) return (RESTORE_ERROR);
+  if ((len < 0) || (restorePos + len > restoreLength)) return (abortRestore());
+
+  for (uint8_t i = 0; i < len; i++) {
+    restoreCrc = _crc_ccitt_update(restoreCrc, data[i]);
+    if (restorePos == restoreNext) {          // marker of the next record
+      restoreCount++;
+      logWrite(restoreBase + restorePos, 0);
+    }
+    else {
+      logWrite(restoreBase + restorePos, data[i]);
+      if (restorePos == restoreNext + 3)      // payload length is complete
+        restoreNext += recordLength(restoreBase + restoreNext);
+    }
+    restorePos++;
+  }
+  storageSync();
+  if (restorePos < restoreLength) return (RESTORE_PENDING);
+
+  // verify the written image (the markers are not written yet)
+  storageFlush();
+  uint16_t crc = 0xffff;
+  storageAddress next = 0;
+  for (storageAddress i = 0; i < restoreLength; i++) {
+    if (i == next) crc = _crc_ccitt_update(crc, RECORD_VALID);
+    else crc = _crc_ccitt_update(crc, logRead(restoreBase + i));
+    if (i == next + 3) next += recordLength(restoreBase + next);
+  }
+  if ((restoreCrc != restoreExpectedCrc) || (crc != restoreExpectedCrc) ||
+      (restoreNext != restoreLength) || (restoreCount != restoreRecords))
+    return (abortRestore());
+  restoreActive = 0;
+
+  // the old records are cleared first: a reset in between leaves an empty log, never a mixed one
+  for (storageAddress address = logTail, used = 0; used < logUsed; ) {
+    storageAddress len = recordLength(address);
+    logWrite(address, 0);
+    used += len;
+    address = logAddress(address + len);
+  }
+  for (next = 0; next < restoreLength; next += recordLength(restoreBase + next))
+    logWrite(restoreBase + next, RECORD_VALID);
+
+  // rebuild the slot directory, load the first slot
+  nextSlot = 0;
+  buildSlotDirectory();
+  storageSync();
+  readFromEEPROM(0);
+  return (RESTORE_DONE);
+}
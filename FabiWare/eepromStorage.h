@@ -5,6 +5,31 @@
      More Information: https://github.com/asterics/FABI
 
      Module: eeprom.h - eeprom memory management
+
+     The slots are stored in a circular, append-only log (EEPROM addresses 0 to LOG_SIZE-1).
+     The memory is accessed via storageBackend.h: internal EEPROM, external I2C EEPROM or a file.
+     Every save appends a new record, the previous record of the slot is marked obsolete.
+     Record format (multi-byte values are little endian):
+       marker (RECORD_VALID or RECORD_OBSOLETE, any other value: no record), type,
+       payload length (2 bytes), sequence number (2 bytes), listing order (2 bytes),
+       payload, crc low, crc high
+       the crc is CRC-16/MCRF4XX (as in binaryProtocol.h) over type, lengths, numbers and payload
+     Record types:
+       RECORD_SLOT    payload: slot name first, the keystrings are string ids (see encodeSlot())
+       RECORD_STRING  payload: string id, keystring (zero terminated)
+     Keystrings are stored once and shared by all slots which use them. The number of
+     references is counted in RAM (at startup from the slot records), a string record
+     becomes obsolete when its last reference is removed.
+     The marker is written last, so an interrupted save leaves no valid record.
+     Obsolete records are only reclaimed when the log is full: the oldest records are
+     removed, live ones are copied to the head of the log first (see ensureSpace()).
+     At startup, the log is found by its oldest record and followed while the records are
+     valid and their sequence numbers increase; if a slot appears twice, the newer record wins.
+     The backends write the bytes in the order of storageWrite() (the internal EEPROM in the
+     background, see eepromWriter.h), so a reset before all bytes are stored has the same
+     effect as an interrupted save.
+     With SLOT_CACHE (see fabi.h), the slot which AT NE loads next is decoded in advance
+     (prefetchNextSlot()), a slot change then only copies it from RAM.
         
      This program is free software; you can redistribute it and/or modify
      it under the terms of the GNU General Public License, see:
@@ -16,22 +41,42 @@
 #ifndef _EEPROMSTORAGE_H_
 #define _EEPROMSTORAGE_H_
 
-#include <EEPROM.h>
+#include "storageBackend.h"
+
+
+#define EEPROM_TOP_ADDRESS  ((storageAddress) (STORAGE_SIZE - 2))   // top address for EEPROM storage, one byte reserved for magic byte
+#define LOG_SIZE    EEPROM_TOP_ADDRESS     // size of the slot log
 
+#define RECORD_VALID              0xA5     // record markers
+#define RECORD_OBSOLETE           0x5A
+#define RECORD_SLOT                  1     // record types
+#define RECORD_STRING                2
+#define RECORD_HEADER_LEN            8     // marker, type, payload length, sequence number, order
+#define RECORD_OVERHEAD  (RECORD_HEADER_LEN + 2)   // header and crc
 
-#define EEPROM_TOP_ADDRESS        1022     // top address for EEPROM storage, one byte reserved for magic byte
+#define EEPROM_IMAGE_CHUNK          32     // bytes per line of an EEPROM image (AT EW)
+#define EEPROM_IMAGE_HEADER_LEN      7     // magic byte, image length, number of slots, crc
+
+#define RESTORE_PENDING   0                // more image data expected
+#define RESTORE_DONE      1                // image was written and verified
+#define RESTORE_ERROR     2                // wrong header, data or checksum
 
 #define REPORT_NONE  0  
 #define REPORT_ONE_SLOT  1
 #define REPORT_ALL_SLOTS 2
 
 uint16_t getfreeEEPROM();
-uint8_t saveToEEPROM(char * slotname);
+uint8_t saveToEEPROM(const char * slotname);
 void bootstrapEEPROM();
-uint8_t readFromEEPROM(char * slotname);
-uint8_t getSlotInfos(char * slotname, uint16_t * s_address, uint16_t * k_address, uint16_t * k_len);
+uint8_t readFromEEPROM(const char * slotname);
 void listSlots();
-uint8_t deleteSlots(char * slotname);
+uint8_t deleteSlots(const char * slotname);
 void printCurrentSlot();
+void dumpEEPROM();
+uint8_t beginRestoreEEPROM(const uint8_t * header, uint8_t len);
+uint8_t restoreEEPROM(const uint8_t * data, int16_t len);
+void prefetchNextSlot();
+
+extern uint8_t slotCacheHit;
 
 #endif
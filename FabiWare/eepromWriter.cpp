@@ -0,0 +1,172 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: eepromWriter.cpp - interrupt driven background writes to the internal EEPROM
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "fabi.h"
+#include "storageBackend.h"
+
+#ifdef STORAGE_INTERNAL_EEPROM
+
+struct eepromRangeType {            // queued bytes for consecutive EEPROM addresses
+  uint16_t address;                 // EEPROM address of the first byte
+  uint8_t  len;                     // number of bytes
+  uint8_t  data;                    // position of the first byte in eepromQueue[]
+};
+
+volatile uint8_t eepromQueue[EEPROM_QUEUE_LEN];                       // queued bytes, in the order of writing
+volatile struct eepromRangeType eepromRanges[EEPROM_QUEUE_RANGES];    // ring buffer of address ranges
+volatile uint8_t rangeTail = 0;     // oldest range, written next (advanced by the ISR)
+volatile uint8_t rangeCount = 0;    // number of queued ranges
+volatile uint8_t queueCount = 0;    // number of queued bytes
+uint8_t queueHead = 0;              // position of the next queued byte in eepromQueue[] (main loop only)
+
+/**
+   @name writeNextByte
+   @param none
+   @return none
+
+   starts writing the oldest queued byte (bytes which are already stored are skipped).
+   Must be called with interrupts disabled and no EEPROM write in progress.
+*/
+void writeNextByte()
+{
+  while (queueCount) {
+    volatile struct eepromRangeType * r = &eepromRanges[rangeTail];
+    uint16_t address = r->address++;
+    uint8_t b = eepromQueue[r->data];
+    r->data = (r->data + 1) & (EEPROM_QUEUE_LEN - 1);
+    queueCount--;
+    if (!--r->len) {
+      rangeTail = (rangeTail + 1) & (EEPROM_QUEUE_RANGES - 1);
+      rangeCount--;
+    }
+    if (EEPROM.read(address) != b) {
+      EEAR = address;
+      EEDR = b;
+      EECR |= (1 << EEMPE);
+      EECR |= (1 << EEPE);         // the write takes ~3.4 ms, then EE_READY_vect follows
+      return;
+    }
+  }
+  EECR &= ~(1 << EERIE);           // queue is empty
+}
+
+/**
+   @name EE_READY_vect
+   @param none
+   @return none
+
+   EEPROM ready interrupt: the previous write is complete, starts the next one
+*/
+ISR(EE_READY_vect)
+{
+  writeNextByte();
+}
+
+/**
+   @name waitForEEPROM
+   @param none
+   @return none
+
+   writes the next queued byte as soon as the EEPROM is ready
+   (used if the main loop has to wait for the queue)
+*/
+void waitForEEPROM()
+{
+  noInterrupts();
+  if (!(EECR & (1 << EEPE))) writeNextByte();
+  interrupts();
+}
+
+/**
+   @name eepromRead
+   @param uint16_t address
+   @return uint8_t  the value of the address, including queued writes
+
+   waits for the write in progress (at most ~3.4 ms) if the address is not queued
+*/
+uint8_t eepromRead(uint16_t address)
+{
+  noInterrupts();
+  for (uint8_t i = rangeCount; i > 0; i--) {     // newest range first
+    volatile struct eepromRangeType * r = &eepromRanges[(rangeTail + i - 1) & (EEPROM_QUEUE_RANGES - 1)];
+    uint16_t offset = address - r->address;
+    if (offset < r->len) {
+      uint8_t b = eepromQueue[(r->data + offset) & (EEPROM_QUEUE_LEN - 1)];
+      interrupts();
+      return (b);
+    }
+  }
+  // the EEPROM can not be read during a write: wait for it with interrupts disabled,
+  // else the EEPROM ready interrupt starts the next queued write before the read
+  while (EECR & (1 << EEPE));
+  uint8_t b = EEPROM.read(address);
+  interrupts();
+  return (b);
+}
+
+/**
+   @name eepromWrite
+   @param uint16_t address
+   @param uint8_t b
+   @return none
+
+   queues a byte for writing, waits only if the queue is full (does not read the
+   EEPROM, which would wait for the write in progress: writeNextByte() skips bytes
+   which are already stored)
+*/
+void eepromWrite(uint16_t address, uint8_t b)
+{
+  while ((queueCount == EEPROM_QUEUE_LEN) || (rangeCount == EEPROM_QUEUE_RANGES))
+    waitForEEPROM();
+
+  noInterrupts();
+  volatile struct eepromRangeType * r = &eepromRanges[(rangeTail + rangeCount - 1) & (EEPROM_QUEUE_RANGES - 1)];
+  if ((!rangeCount) || ((uint16_t)(r->address + r->len) != address)) {     // start a new range
+    r = &eepromRanges[(rangeTail + rangeCount) & (EEPROM_QUEUE_RANGES - 1)];
+    r->address = address;
+    r->len = 0;
+    r->data = queueHead;
+    rangeCount++;
+  }
+  eepromQueue[queueHead] = b;
+  queueHead = (queueHead + 1) & (EEPROM_QUEUE_LEN - 1);
+  r->len++;
+  queueCount++;
+  EECR |= (1 << EERIE);
+  interrupts();
+}
+
+/**
+   @name flushEEPROM
+   @param none
+   @return none
+
+   waits until all queued bytes are written to the EEPROM
+*/
+void flushEEPROM()
+{
+  while (queueCount) waitForEEPROM();
+  while (EECR & (1 << EEPE));
+}
+
+/**
+   @name eepromPending
+   @param none
+   @return uint8_t  number of queued bytes
+*/
+uint8_t eepromPending()
+{
+  return (queueCount);
+}
+
+#endif
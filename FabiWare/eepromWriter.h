@@ -0,0 +1,35 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: eepromWriter.h - interrupt driven background writes to the internal EEPROM
+
+     Writing an EEPROM byte takes ~3.4 ms. eepromWrite() only appends the byte to a
+     queue in RAM, the EEPROM ready interrupt writes the queued bytes one after another
+     (in the order of the eepromWrite() calls). Consecutive addresses are kept as ranges,
+     eepromRead() returns the queued value of an address if there is one.
+     eepromWrite() only waits if the queue is full, flushEEPROM() waits until all
+     queued bytes are written.
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+
+#ifndef _EEPROMWRITER_H_
+#define _EEPROMWRITER_H_
+
+#include <EEPROM.h>
+
+#define EEPROM_QUEUE_LEN        64   // queued bytes, must be a power of 2
+#define EEPROM_QUEUE_RANGES      8   // queued address ranges, must be a power of 2
+
+uint8_t eepromRead(uint16_t address);
+void eepromWrite(uint16_t address, uint8_t b);
+void flushEEPROM();
+uint8_t eepromPending();
+
+#endif
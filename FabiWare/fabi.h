@@ -19,6 +19,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <avr/pgmspace.h>
+#include "hostSerial.h"
 #include "commands.h"
 #include "bluetooth.h"
 #include "hid_hal.h"
@@ -33,14 +34,21 @@
 #define VERSION_STRING "FABI v2.8"
 
 //#define DEBUG_OUTPUT      //  if debug output is desired
+//#define LATENCY_HISTOGRAM //  if switch-to-HID latency statistics are desired (AT LH), needs ~400 bytes RAM
+//#define LOOP_PROFILER     //  if run time statistics of the main loop stages are desired (AT PR), needs ~140 bytes RAM
+//#define TELEMETRY_BURST   //  if burst capture of telemetry samples is desired (AT BU), needs ~580 bytes RAM
+//#define STORAGE_I2C_EEPROM 32768  //  if the slots are stored in an external 24LCxx I2C EEPROM of this size in bytes
+                                    //  (e.g. 32768 for a 24LC256, up to 65536), instead of the internal 1 KB EEPROM
+//#define SLOT_CACHE        //  if the next slot is decoded in advance, for slot changes without EEPROM access (AT NE), needs ~190 bytes RAM
 
 #include <Mouse.h>
 #include <Keyboard.h>
 
-#define NUMBER_OF_BUTTONS  11         // number of pyhsical plus virtual switches, note: if more than 16, change buttonState type to uint32_t!
+#define NUMBER_OF_BUTTONS  13         // number of pyhsical plus virtual switches, note: if more than 16, change buttonState type to uint32_t!
 
 #define MAX_SLOTNAME_LEN      12      // maximum lenght for a slotname
 #define KEYSTRING_BUFFER_LEN 300      // maximum lenght for all string parameters of a slot 
+#define SLOT_CACHE_KEYSTRING_LEN 96   // keystrings of a slot in the slot cache (slots with longer keystrings are not cached)
 #define MAX_CMDLEN           100      // maximum lenght of a single AT command
 #define RELEASE_ALL_TIMEOUT 2500      // timeout for button release @slot changes etc.
 
@@ -50,6 +58,9 @@
 #define DEFAULT_WHEEL_STEPSIZE       3   // stepsize for scroll wheel
 #define DEFAULT_SIP_THRESHOLD        0   // sip action disabled per default
 #define DEFAULT_PUFF_THRESHOLD    1023   // puff action disabled per default
+#define DEFAULT_STRONG_SIP_THRESHOLD 0   // strong sip action disabled per default
+#define DEFAULT_STRONG_PUFF_THRESHOLD 1023  // strong puff action disabled per default
+#define DEFAULT_SIP_PUFF_HYSTERESIS 20   // sip/puff release this far below the threshold
 #define DEFAULT_ANTITREMOR_PRESS     5   // debouncing interval for button-press
 #define DEFAULT_ANTITREMOR_RELEASE   2   // debouncing interval for button-release
 #define DEFAULT_ANTITREMOR_IDLE      1   // debouncing interval for button idle time
@@ -64,6 +75,9 @@ struct settingsType {
   uint16_t tt;     // threshold time for longpress 
   uint16_t ts;     // threshold sip
   uint16_t tp;     // threshold puff 
+  uint16_t ss;     // threshold strong sip
+  uint16_t sp;     // threshold strong puff
+  uint16_t sh;     // sip/puff hysteresis
   uint16_t ap;     // antitremor press time 
   uint16_t ar;     // antitremor release time 
   uint16_t ai;     // antitremor idle time
@@ -73,6 +87,14 @@ struct settingsType {
   uint32_t sc;     // slotcolor (0x: rrggbb)
 };
 
+struct settingFieldType {           // a field of struct settingsType, see settingFields[]
+  uint8_t cmd;                      // the AT command which changes the setting
+  uint8_t offset;                   // position in struct settingsType
+  uint8_t size;                     // size in bytes
+};
+
+#define NUM_SETTING_FIELDS 14       // note: the order of settingFields[] is part of the EEPROM slot format
+
 struct atCommandType {              // holds settings for a button function 
   char atCmd[3];
   uint8_t  partype;   // type of parameter: int, uint or string
@@ -95,12 +117,14 @@ extern uint8_t actSlot;
 extern uint8_t addonUpgrade;
 extern uint8_t reportSlotParameters;
 extern uint8_t reportRawValues;
+extern uint16_t buttonStates;
+extern uint16_t pressure;
 extern struct settingsType settings;
 extern const struct settingsType defaultSettings;
-extern int EmptySlotAddress;
 extern struct buttonType buttons[NUMBER_OF_BUTTONS];
 extern struct buttonDebouncerType buttonDebouncers[NUMBER_OF_BUTTONS];
 extern const struct atCommandType atCommands[];
+extern const struct settingFieldType settingFields[];
 extern char cmdstring[MAX_CMDLEN];                 // buffer for incoming AT commands
 extern char keystringBuffer[KEYSTRING_BUFFER_LEN]; // buffer for all string parameters for the buttons of a slot
 
@@ -117,11 +141,14 @@ extern char * writeKeystring;
 extern int8_t moveX;       
 extern int8_t moveY;
 
+void indexKeystrings ();
 char * getKeystring (uint8_t button);
-void setKeystring (uint8_t button, char * text);
+void setKeystring (uint8_t button, const char * text);
 void printKeystrings ();
 uint16_t  keystringMemUsage(uint8_t button);
 void parseCommand (char * cmdstr);
+char charUp (char c);
+int16_t get_hex(char * str, uint8_t * result, uint8_t maxlen);
 void parseByte (int newByte);
 
 #define strcpy_FM   strcpy_PF
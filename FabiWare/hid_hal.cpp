@@ -13,23 +13,32 @@
 
 
 #include "hid_hal.h"
+#include "diagnostics.h"
 
 void mouseRelease(uint8_t button)
 {
-  if (settings.bt & 1)
+  if (settings.bt & 1) {
     Mouse.release(button);
+    recordLatency(LATENCY_USB);
+  }
 
-  if ((settings.bt & 2) && (isBluetoothAvailable()))
+  if ((settings.bt & 2) && (isBluetoothAvailable())) {
     mouseBTRelease(button);
+    recordLatency(LATENCY_BT);
+  }
 }
 
 void mousePress(uint8_t button)
 {
-  if (settings.bt & 1)
+  if (settings.bt & 1) {
     Mouse.press(button);
+    recordLatency(LATENCY_USB);
+  }
 
-  if ((settings.bt & 2) && (isBluetoothAvailable()))
+  if ((settings.bt & 2) && (isBluetoothAvailable())) {
     mouseBTPress(button);
+    recordLatency(LATENCY_BT);
+  }
 }
 
 void mouseToggle(uint8_t button)
@@ -37,22 +46,28 @@ void mouseToggle(uint8_t button)
   if (settings.bt & 1) {
     if (Mouse.isPressed(button))
       Mouse.release(button); else Mouse.press(button);
+    recordLatency(LATENCY_USB);
   }
 
   if ((settings.bt & 2) && (isBluetoothAvailable())) {
     if (isMouseBTPressed(button))
       mouseBTRelease(button); else mouseBTPress(button);
+    recordLatency(LATENCY_BT);
   }
 }
 
 
 void mouseScroll(int8_t steps)
 {
-  if (settings.bt & 1)
+  if (settings.bt & 1) {
     Mouse.move(0,0,steps); 
+    recordLatency(LATENCY_USB);
+  }
 
-  if ((settings.bt & 2) && (isBluetoothAvailable()))
+  if ((settings.bt & 2) && (isBluetoothAvailable())) {
     mouseBT(0, 0, steps);
+    recordLatency(LATENCY_BT);
+  }
 }
 
 void mouseMove(int x, int y)
@@ -89,33 +104,49 @@ void mouseMove(int x, int y)
     y -= 127;
   }
 
-  if (settings.bt & 1)
+  if (settings.bt & 1) {
     Mouse.move(x, y);
-  if ((settings.bt & 2) && (isBluetoothAvailable()))
+    recordLatency(LATENCY_USB);
+  }
+  if ((settings.bt & 2) && (isBluetoothAvailable())) {
     mouseBT(x, y, 0);
+    recordLatency(LATENCY_BT);
+  }
 }
 
 
 void keyboardPress(int key)
 {
-  if (settings.bt & 1)
+  if (settings.bt & 1) {
     Keyboard.press(key);
-  if ((settings.bt & 2) && (isBluetoothAvailable()))
+    recordLatency(LATENCY_USB);
+  }
+  if ((settings.bt & 2) && (isBluetoothAvailable())) {
     keyboardBTPress(key);
+    recordLatency(LATENCY_BT);
+  }
 }
 
 void keyboardRelease(int key)
 {
-  if (settings.bt & 1)
+  if (settings.bt & 1) {
     Keyboard.release(key);
-  if ((settings.bt & 2) && (isBluetoothAvailable()))
+    recordLatency(LATENCY_USB);
+  }
+  if ((settings.bt & 2) && (isBluetoothAvailable())) {
     keyboardBTRelease(key);
+    recordLatency(LATENCY_BT);
+  }
 }
 
 void keyboardReleaseAll()
 {
-  if (settings.bt & 1)
+  if (settings.bt & 1) {
     Keyboard.releaseAll();
-  if ((settings.bt & 2) && (isBluetoothAvailable()))
+    recordLatency(LATENCY_USB);
+  }
+  if ((settings.bt & 2) && (isBluetoothAvailable())) {
     keyboardBTReleaseAll();
+    recordLatency(LATENCY_BT);
+  }
 }
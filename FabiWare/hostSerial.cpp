@@ -0,0 +1,218 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: hostSerial.cpp - serial connection to the host (configuration manager)
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "fabi.h"
+
+HostSerial hostSerial;
+
+void HostSerial::begin(unsigned long baud) { Serial.begin(baud); }
+int HostSerial::available() { return (Serial.available()); }
+int HostSerial::read() { return (Serial.read()); }
+int HostSerial::peek() { return (Serial.peek()); }
+int HostSerial::availableForWrite() { return (TX_QUEUE_LEN - txCount); }
+HostSerial::operator bool() { return (Serial); }
+
+/**
+   @name drain
+   @param uint8_t waitForSpace  if 0, only as many bytes as the USB endpoint can take are sent
+   @return uint8_t  number of bytes which were removed from the transmit queue
+*/
+uint8_t HostSerial::drain(uint8_t waitForSpace)
+{
+  uint8_t len = txCount;
+  if (len > TX_QUEUE_LEN - txTail) len = TX_QUEUE_LEN - txTail;   // contiguous part only
+  if (!waitForSpace) {
+    int space = Serial.availableForWrite();
+    if (len > space) len = space;
+  }
+  if (!len) return (0);
+
+  Serial.write(txQueue + txTail, len);
+  txTail = (txTail + len) % TX_QUEUE_LEN;
+  txCount -= len;
+  return (len);
+}
+
+/**
+   @name update
+   @param none
+   @return none
+
+   sends queued bytes to the host without blocking, called once per loop iteration
+*/
+void HostSerial::update()
+{
+  while (txCount && drain(0)) ;
+}
+
+/**
+   @name flush
+   @param none
+   @return none
+
+   waits until all queued bytes have been sent
+*/
+void HostSerial::flush()
+{
+  while (txCount) drain(1);
+  Serial.flush();
+}
+
+/**
+   @name beginTelemetry
+   @param none
+   @return none
+
+   the following output (until endTelemetry()) is discarded as a whole 
+   if it does not fit into the transmit queue
+*/
+void HostSerial::beginTelemetry()
+{
+  telemetry = 1;
+  telemetryQueued = 0;
+  telemetryDropped = 0;
+}
+
+/**
+   @name endTelemetry
+   @param none
+   @return uint8_t  1 if the output since beginTelemetry() was dropped
+*/
+uint8_t HostSerial::endTelemetry()
+{
+  if (telemetryDropped) droppedLines++;
+  telemetry = 0;
+  return (telemetryDropped);
+}
+
+/**
+   @name printQueueStatistics
+   @param none
+   @return none
+
+   prints the peak fill level of the transmit queue and the dropped telemetry, 
+   and resets these statistics
+*/
+void HostSerial::printQueueStatistics()
+{
+  // take a snapshot first: the printed text itself goes through the queue
+  uint8_t peak = maxQueued;
+  uint32_t bytes = droppedBytes;
+  uint16_t lines = droppedLines;
+
+  print(F("TX QUEUE:")); print(peak); print('/'); println(TX_QUEUE_LEN);
+  print(F("DROPPED:")); print(bytes); print(F(" bytes,")); print(lines); println(F(" lines"));
+  maxQueued = txCount;
+  droppedBytes = 0;
+  droppedLines = 0;
+}
+
+void HostSerial::put(uint8_t c)
+{
+  if (telemetry) {
+    if (telemetryDropped) {
+      droppedBytes++;
+      return;
+    }
+    if (txCount == TX_QUEUE_LEN) {
+      // no space: remove the part of this telemetry output which is already queued
+      // (counted, as it can fill the whole queue)
+      txHead = (txHead + TX_QUEUE_LEN - telemetryQueued) % TX_QUEUE_LEN;
+      txCount -= telemetryQueued;
+      droppedBytes += telemetryQueued + 1;
+      telemetryDropped = 1;
+      return;
+    }
+    telemetryQueued++;
+  }
+  else {
+    while (txCount == TX_QUEUE_LEN) drain(1);   // responses are never dropped
+  }
+
+  txQueue[txHead] = c;
+  txHead = (txHead + 1) % TX_QUEUE_LEN;
+  txCount++;
+  if (txCount > maxQueued) maxQueued = txCount;
+}
+
+/**
+   @name setTag
+   @param const char * newTag  the tag of the command which is processed now
+   @return none
+
+   all following lines are prefixed with "#<tag> " until clearTag() is called
+*/
+void HostSerial::setTag(const char * newTag)
+{
+  strncpy(tag, newTag, MAX_TAG_LEN);
+  tag[MAX_TAG_LEN] = 0;
+  lineStart = 1;
+  tagWritten = 0;
+}
+
+/**
+   @name clearTag
+   @param none
+   @return none
+
+   ends the tagged output (an unterminated line is finished)
+*/
+void HostSerial::clearTag()
+{
+  if (!lineStart) write("\r\n");
+  tag[0] = 0;
+  lineStart = 1;
+}
+
+/**
+   @name tagUsed
+   @param none
+   @return uint8_t  1 if a line was sent since setTag(), or the tag was taken over (takeTag())
+*/
+uint8_t HostSerial::tagUsed()
+{
+  return (tagWritten);
+}
+
+/**
+   @name takeTag
+   @param char * buffer  receives the tag (MAX_TAG_LEN + 1 bytes), empty if the command has no tag
+   @return none
+
+   takes over the tag of the current command, for a command which completes later:
+   the following lines are not tagged and parseByte() does not send "#<tag> OK",
+   the caller sends the reply with the tag when the command is finished.
+*/
+void HostSerial::takeTag(char * buffer)
+{
+  strcpy(buffer, tag);
+  tag[0] = 0;
+  if (buffer[0]) tagWritten = 1;
+}
+
+void HostSerial::writeTag()
+{
+  put('#');
+  for (uint8_t i = 0; tag[i]; i++) put(tag[i]);
+  put(' ');
+  lineStart = 0;
+  tagWritten = 1;
+}
+
+size_t HostSerial::write(uint8_t c)
+{
+  if (tag[0] && lineStart) writeTag();
+  lineStart = (c == '\n');
+  put(c);
+  return (1);
+}
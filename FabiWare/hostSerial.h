@@ -0,0 +1,68 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: hostSerial.h - serial connection to the host (configuration manager)
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+
+#ifndef _HOSTSERIAL_H_
+#define _HOSTSERIAL_H_
+
+#define MAX_TAG_LEN  5      // maximum length of a command tag ("AT#<tag> ...")
+#define TX_QUEUE_LEN 128    // size of the transmit queue for the host (bytes)
+
+/**
+   all communication with the host goes through this wrapper of the USB serial port:
+   while a tagged command is processed, every line which is sent to the host 
+   starts with "#<tag> ", so that the host can match the responses to its commands.
+   outgoing bytes are queued and sent by update() as far as the USB endpoint accepts them.
+   lines which are written between beginTelemetry() and endTelemetry() are dropped 
+   if they do not fit into the queue, all other output waits until space is available.
+*/
+class HostSerial : public Stream {
+  public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    int peek();
+    void flush();
+    size_t write(uint8_t c);
+    using Print::write;
+    int availableForWrite();
+    operator bool();
+
+    void update();
+    void beginTelemetry();
+    uint8_t endTelemetry();
+    void printQueueStatistics();
+
+    void setTag(const char * newTag);
+    void clearTag();
+    uint8_t tagUsed();
+    void takeTag(char * buffer);
+
+  private:
+    void writeTag();
+    void put(uint8_t c);
+    uint8_t drain(uint8_t waitForSpace);
+    uint8_t txQueue[TX_QUEUE_LEN];
+    uint8_t txHead, txTail, txCount;
+    uint8_t telemetry, telemetryQueued, telemetryDropped;   // telemetryQueued: bytes of the current telemetry output
+    uint8_t maxQueued;
+    uint32_t droppedBytes;
+    uint16_t droppedLines;
+    char tag[MAX_TAG_LEN + 1];
+    uint8_t lineStart;
+    uint8_t tagWritten;
+};
+
+extern HostSerial hostSerial;
+
+#endif
@@ -18,37 +18,45 @@
 
 
 int storedKeys[HID_REPORT_KEY_COUNT]={0};  // arrays for keycodes of currently pressed keys
+uint16_t keyActions[KEY_ACTION_BUFFER_LEN];         // compiled keycodes of all buttons, see compileKeyActions()
+uint8_t keyActionStart[NUMBER_OF_BUTTONS];          // index of the first keycode of a button in keyActions[]
+uint8_t keyActionCount[NUMBER_OF_BUTTONS];          // number of keycodes of a button, or KEY_ACTIONS_NONE
 extern const int usToDE[];                 // translation map for keycodes, see below
 
 
 // this keymap associates keycode-strings to the actual key codes
+// note: the entries must be sorted by their names (strcmp order), see getKeycode()
 //
-const keymap_struct keymap[] PROGMEM  = {   
-  {"SHIFT", KEY_LEFT_SHIFT},
-  {"CTRL", KEY_LEFT_CTRL},
+constexpr keymap_struct keymap[] PROGMEM  = {   
+  {"0", KEY_0},
+  {"1", KEY_1},
+  {"2", KEY_2},
+  {"3", KEY_3},
+  {"4", KEY_4},
+  {"5", KEY_5},
+  {"6", KEY_6},
+  {"7", KEY_7},
+  {"8", KEY_8},
+  {"9", KEY_9},
+  {"A", KEY_A},
   {"ALT", KEY_LEFT_ALT},
-  {"RIGHT_ALT", KEY_RIGHT_ALT},
-  {"GUI", KEY_LEFT_GUI},
-  {"RIGHT_GUI", KEY_RIGHT_GUI},
-  {"UP", KEY_UP},
+  {"ASTERISK", 125},
+  {"B", KEY_B},
+  {"BACKSPACE", KEY_BACKSPACE},
+  {"C", KEY_C},
+  {"CAPS_LOCK", KEY_CAPS_LOCK},
+  {"COLON", 62},
+  {"CTRL", KEY_LEFT_CTRL},
+  {"D", KEY_D},
+  {"DELETE", KEY_DELETE},
+  {"DOT", 46},
   {"DOWN", KEY_DOWN},
-  {"LEFT", KEY_LEFT},
-  {"RIGHT", KEY_RIGHT},
+  {"E", KEY_E},
+  {"END", KEY_END},
   {"ENTER", KEY_ENTER},
-  {"SPACE", KEY_SPACE},
   {"ESC", KEY_ESC},
-  {"BACKSPACE", KEY_BACKSPACE},
-  {"TAB", KEY_TAB},
-  {"CAPS_LOCK", KEY_CAPS_LOCK},
+  {"F", KEY_F},
   {"F1", KEY_F1},
-  {"F2", KEY_F2},
-  {"F3", KEY_F3},
-  {"F4", KEY_F4},
-  {"F5", KEY_F5},
-  {"F6", KEY_F6},
-  {"F7", KEY_F7},
-  {"F8", KEY_F8},
-  {"F9", KEY_F9},
   {"F10", KEY_F10},
   {"F11", KEY_F11},
   {"F12", KEY_F12},
@@ -59,91 +67,99 @@ const keymap_struct keymap[] PROGMEM  = {
   {"F17", KEY_F17},
   {"F18", KEY_F18},
   {"F19", KEY_F19},
+  {"F2", KEY_F2},
   {"F20", KEY_F20},
   {"F21", KEY_F21},
   {"F22", KEY_F22},
   {"F23", KEY_F23},
   {"F24", KEY_F24},
-  {"INSERT", KEY_INSERT},
-  {"HOME", KEY_HOME},
-  {"PAGE_UP", KEY_PAGE_UP},
-  {"DELETE", KEY_DELETE},
-  {"END", KEY_END},
-  {"PAGE_DOWN", KEY_PAGE_DOWN},
-  {"A", KEY_A},
-  {"B", KEY_B},
-  {"C", KEY_C},
-  {"D", KEY_D},
-  {"E", KEY_E},
-  {"F", KEY_F},
+  {"F3", KEY_F3},
+  {"F4", KEY_F4},
+  {"F5", KEY_F5},
+  {"F6", KEY_F6},
+  {"F7", KEY_F7},
+  {"F8", KEY_F8},
+  {"F9", KEY_F9},
   {"G", KEY_G},
+  {"GUI", KEY_LEFT_GUI},
   {"H", KEY_H},
+  {"HASH", 0xba},
+  {"HOME", KEY_HOME},
   {"I", KEY_I},
+  {"INSERT", KEY_INSERT},
   {"J", KEY_J},
   {"K", KEY_K},
+  {"KP_ASTERISK", 0xdd},
+  {"KP_MINUS", 0xde},
+  {"KP_PLUS", 0xdf},
+  {"KP_SLASH", 0xdc},
   {"L", KEY_L},
+  {"LEFT", KEY_LEFT},
   {"M", KEY_M},
+  {"MINUS", 47},
   {"N", KEY_N},
   {"O", KEY_O},
   {"P", KEY_P},
+  {"PAGE_DOWN", KEY_PAGE_DOWN},
+  {"PAGE_UP", KEY_PAGE_UP},
+  {"PLUS", 184},
   {"Q", KEY_Q},
   {"R", KEY_R},
+  {"RIGHT", KEY_RIGHT},
+  {"RIGHT_ALT", KEY_RIGHT_ALT},
+  {"RIGHT_GUI", KEY_RIGHT_GUI},
   {"S", KEY_S},
+  {"SEMICOLON", 60},
+  {"SHIFT", KEY_LEFT_SHIFT},
+  {"SLASH", 38},
+  {"SPACE", KEY_SPACE},
   {"T", KEY_T},
+  {"TAB", KEY_TAB},
   {"U", KEY_U},
+  {"UP", KEY_UP},
   {"V", KEY_V},
   {"W", KEY_W},
   {"X", KEY_X},
   {"Y", KEY_Y},
   {"Z", KEY_Z},
-  {"1", KEY_1},
-  {"2", KEY_2},
-  {"3", KEY_3},
-  {"4", KEY_4},
-  {"5", KEY_5},
-  {"6", KEY_6},
-  {"7", KEY_7},
-  {"8", KEY_8},
-  {"9", KEY_9},
-  {"0", KEY_0},
-  {"PLUS", 184},
-  {"MINUS", 47},
-  {"ASTERISK", 125},
-  {"SLASH", 38},
-  {"DOT", 46},
-  {"COLON", 62},
-  {"SEMICOLON", 60},
-  {"HASH", 0xba},
-  {"KP_PLUS", 0xdf},
-  {"KP_MINUS", 0xde},
-  {"KP_ASTERISK", 0xdd},
-  {"KP_SLASH", 0xdc},
 };
 
 #define KEYMAP_ELEMENTS (sizeof keymap / sizeof keymap[0])
 
+// compile time check of the keymap order
+constexpr int compareKeyNames(const char * a, const char * b)
+{
+  return ((*a != *b) || !*a) ? (uint8_t)*a - (uint8_t)*b : compareKeyNames(a + 1, b + 1);
+}
+
+constexpr bool keymapIsSorted(size_t i)
+{
+  return (i + 1 >= KEYMAP_ELEMENTS) ? true :
+         (compareKeyNames(keymap[i].token, keymap[i + 1].token) < 0) && keymapIsSorted(i + 1);
+}
+
+static_assert(keymapIsSorted(0), "keymap[] is not sorted by key names");
+
 /**
    @name getKeycode
    @param char* acttoken
    @return int
 
    returns a keycode for a given keycode-string (acttoken)
+   (binary search in keymap[], the names are compared in PROGMEM)
 */
 int getKeycode(char* acttoken)
 {
-    keymap_struct keyRAM;    
-    if (!strncmp(acttoken, "KEY_", 4)) {
-      acttoken += 4;
-      for (int i = 0; i < KEYMAP_ELEMENTS; i++) {
-        // Serial.print("scanning for ");  Serial.println(keymap[i].token);
-        // if (!strcmp_FM(acttoken,(uint_farptr_t_FM)keymap[i].token)) {
-
-        memcpy_P( &keyRAM, &keymap[i], sizeof(keymap[0]));
-        if (!strcmp(acttoken, keyRAM.token)) {
-          // Serial.print ("found "); Serial.println (keyRAM.key);
-          return(keyRAM.key);
-        }
-      }
+    if (strncmp(acttoken, "KEY_", 4)) return(0);
+    acttoken += 4;
+
+    uint8_t low = 0, high = KEYMAP_ELEMENTS;
+    while (low < high) {
+      uint8_t mid = (low + high) / 2;
+      int cmp = strcmp_P(acttoken, keymap[mid].token);
+      if (!cmp) return(pgm_read_byte_near(&keymap[mid].key));
+      if (cmp < 0) high = mid;
+      else low = mid + 1;
     }
     return(0);
 }
@@ -152,20 +168,25 @@ int getKeycode(char* acttoken)
    @name getNextKeyName
    @param char* keyNames
    @param char* singleKeyName
+   @param uint8_t maxLen  size of singleKeyName
    @return uint16_t
 
    stores the first keycode-string into "singleKeyName" and returns its lenght
+   (including leading spaces). A name which does not fit into maxLen bytes is no valid key:
+   it is skipped and an empty string is stored.
    Note: this function is called multiple times in order to 
    tokenizes a string which contains multiple keycode-stings (eg. "KEY_A KEY_B")
  
 */
-uint16_t getNextKeyName(char* keyNames, char* singleKeyName)
+uint16_t getNextKeyName(char* keyNames, char* singleKeyName, uint8_t maxLen)
 {
   int i=0,j=0;
   while (keyNames[i]==' ') i++;
   while ((keyNames[i]!=' ') && (keyNames[i])) {
-     singleKeyName[j++]=keyNames[i++];
+     if (j < maxLen-1) singleKeyName[j]=keyNames[i];
+     i++; j++;
   }
+  if (j >= maxLen) j=0;
   singleKeyName[j]=0;
   return(i);
 }
@@ -214,6 +235,31 @@ int keyStored(int k) {
 }
 
 
+/**
+   @name pressKey / releaseKey / toggleKey
+   @param int kc  the keycode
+   @return none
+
+   press, release or toggle a single key and keep track of the pressed keys
+*/
+void pressKey(int kc)
+{
+  keyboardPress(kc);
+  storeKey(kc);
+}
+
+void releaseKey(int kc)
+{
+  keyboardRelease(kc);
+  removeKey(kc);
+}
+
+void toggleKey(int kc)
+{
+  if (keyStored(kc)) releaseKey(kc);
+  else pressKey(kc);
+}
+
 /**
    @name pressSingleKeys
    @param char* keyNames
@@ -226,14 +272,10 @@ void pressSingleKeys(char* keyNames)
 {
   int len;
   char singleKeyName[20];   // e.g. KEY_A
-  while (len=getNextKeyName(keyNames,singleKeyName))
+  while (len=getNextKeyName(keyNames,singleKeyName,sizeof(singleKeyName)))
   {
     int kc=getKeycode(singleKeyName);
-    if (kc) {
-     keyboardPress(kc);
-     storeKey(kc);
-     // Serial.print ("press key ");  Serial.println (kc);
-    }
+    if (kc) pressKey(kc);
     keyNames+=len;
   }
 }
@@ -250,13 +292,10 @@ void releaseSingleKeys (char * keyNames)
 {
   int len;
   char singleKeyName[20];
-  while (len=getNextKeyName(keyNames,singleKeyName))
+  while (len=getNextKeyName(keyNames,singleKeyName,sizeof(singleKeyName)))
   {
     int kc=getKeycode(singleKeyName);
-    if (kc) {
-      keyboardRelease(kc);
-      removeKey(kc);
-    }
+    if (kc) releaseKey(kc);
     keyNames+=len;
   }
 }
@@ -274,20 +313,49 @@ void toggleSingleKeys(char* keyNames)
 {
   int len;
   char singleKeyName[20];   // e.g. KEY_A
-  while (len=getNextKeyName(keyNames,singleKeyName))
+  while (len=getNextKeyName(keyNames,singleKeyName,sizeof(singleKeyName)))
   {
     int kc=getKeycode(singleKeyName);
-    if (kc) {
-      if (keyStored(kc)) { keyboardRelease(kc); removeKey(kc); }
-      else { keyboardPress(kc); storeKey(kc);}
-      // Serial.print ("toggle key ");  Serial.println (kc);
-    }
+    if (kc) toggleKey(kc);
     keyNames+=len;
   }
 }
 
 
 
+/**
+   @name translateKey
+   @param char c  the character
+   @return int  keycode, translated to locale (with MOD_ALTGR / MOD_SHIFT flags)
+*/
+int translateKey(char c)
+{
+   if (KEYBOARD_LAYOUT == KBD_DE)
+      return (pgm_read_word_near(&(usToDE[(uint8_t)c])));  // get the translated keycode (DE layout)
+   return (c);
+}
+
+/**
+   @name typeKey
+   @param int k  keycode, optionally with MOD_ALTGR / MOD_SHIFT flags
+   @return none
+   
+   press and release a key, using the modifier keys given by the flags
+*/
+void typeKey(int k)
+{
+   // Serial.print ("key:"); Serial.print(k&0xff); Serial.print(" (");
+   // if (k&MOD_ALTGR) Serial.print("AltGr + "); if (k&MOD_SHIFT) Serial.print("Shift + "); 
+   // Serial.print((char)(k&0xff)); Serial.println(")");
+
+   if (k&MOD_ALTGR) keyboardPress(KEY_RIGHT_ALT); 
+   if (k&MOD_SHIFT) keyboardPress(KEY_LEFT_SHIFT); 
+   keyboardPress(k&0xff); 
+   keyboardRelease(k&0xff); 
+   if (k&MOD_SHIFT) keyboardRelease(KEY_LEFT_SHIFT); 
+   if (k&MOD_ALTGR) keyboardRelease(KEY_RIGHT_ALT);
+}
+
 /**
    @name writeTranslatedKeys
    @param char * str
@@ -298,23 +366,8 @@ void toggleSingleKeys(char* keyNames)
 */
 void writeTranslatedKeys(char * str, int len)
 {
-   int k;
-   for (int i=0; i<len; i++) {
-      if (KEYBOARD_LAYOUT == KBD_DE)
-         k=pgm_read_word_near(&(usToDE[(uint8_t)str[i]]));  // get the translated keycode (DE layout)
-      else k=str[i];
-      
-      // Serial.print ("char:"); Serial.print(str[i]); Serial.print(" -> ");Serial.print(k);Serial.print(" (");
-      // if (k&MOD_ALTGR) Serial.print("AltGr + "); if (k&MOD_SHIFT) Serial.print("Shift + "); 
-      // Serial.print((char)(k&0xff)); Serial.println(")");
-
-      if (k&MOD_ALTGR) keyboardPress(KEY_RIGHT_ALT); 
-      if (k&MOD_SHIFT) keyboardPress(KEY_LEFT_SHIFT); 
-      keyboardPress(k&0xff); 
-      keyboardRelease(k&0xff); 
-      if (k&MOD_SHIFT) keyboardRelease(KEY_LEFT_SHIFT); 
-      if (k&MOD_ALTGR) keyboardRelease(KEY_RIGHT_ALT);
-   }
+   for (int i=0; i<len; i++)
+      typeKey(translateKey(str[i]));
 }
 
 
@@ -335,14 +388,11 @@ void sendToKeyboard(char * writeKeystring)
         // write all normal characters until the special key position
         writeTranslatedKeys (actpos, specialKeyLocation-actpos);
         //extract name of special key
-        getNextKeyName(specialKeyLocation,singleKeyName);
+        int len=getNextKeyName(specialKeyLocation,singleKeyName,sizeof(singleKeyName));
         int kc=getKeycode(singleKeyName);
-        if (kc)  {
-           keyboardPress(kc);
-           keyboardRelease(kc);
-        }
+        if (kc) typeKey(kc);
         // continue after special key name
-        actpos= specialKeyLocation+strlen(singleKeyName);
+        actpos= specialKeyLocation+len;
         specialKeyLocation=strstr(actpos,"KEY_");
     }
     // write remainder of normal characters   
@@ -370,6 +420,96 @@ void release_all()
 }
 
 
+/**
+   @name compileKeystring
+   @param char * str  the keystring
+   @param uint8_t write  1: the keystring is a text (AT KW), 0: a list of key identifiers (AT KP / KH / KT / KR)
+   @param uint16_t * actions  receives the keycodes
+   @param uint8_t maxActions  maximum number of keycodes
+   @return int16_t  number of keycodes, -1 if they do not fit
+   
+   resolves a keystring in the same way as sendToKeyboard() or pressSingleKeys() do, 
+   text characters are translated to locale (with MOD_ALTGR / MOD_SHIFT flags)
+*/
+int16_t compileKeystring(char * str, uint8_t write, uint16_t * actions, uint8_t maxActions)
+{
+  char singleKeyName[20];
+  uint8_t count = 0;
+  int len, kc;
+
+  while (*str) {
+    if (!write || !strncmp(str, "KEY_", 4)) {
+      if (!(len = getNextKeyName(str, singleKeyName, sizeof(singleKeyName)))) break;
+      kc = getKeycode(singleKeyName);
+    }
+    else {
+      kc = translateKey(*str);
+      len = 1;
+    }
+    str += len;
+    if (!kc) continue;
+    if (count == maxActions) return (-1);
+    actions[count++] = kc;
+  }
+  return (count);
+}
+
+/**
+   @name compileKeyActions
+   @param none
+   @return none
+   
+   resolves the keystrings of all buttons with key commands (KW / KP / KH / KT / KR) to keycodes,
+   so that a button press does not need to parse the keystring and search the keymap.
+   must be called after the button modes or keystrings were changed.
+   if the keycodes do not fit into keyActions[], the button uses its keystring.
+*/
+void compileKeyActions()
+{
+  uint8_t used = 0;
+
+  for (uint8_t i = 0; i < NUMBER_OF_BUTTONS; i++) {
+    uint8_t mode = buttons[i].mode;
+    int16_t count = -1;
+
+    if ((mode == CMD_KW) || (mode == CMD_KP) || (mode == CMD_KH) || (mode == CMD_KT) || (mode == CMD_KR))
+      count = compileKeystring(getKeystring(i), mode == CMD_KW, keyActions + used, KEY_ACTION_BUFFER_LEN - used);
+    keyActionStart[i] = used;
+    if (count < 0) keyActionCount[i] = KEY_ACTIONS_NONE;
+    else {
+      keyActionCount[i] = count;
+      used += count;
+    }
+  }
+}
+
+/**
+   @name replayKeyActions
+   @param uint8_t button  the button index
+   @param uint8_t cmd  the key command (CMD_KW, CMD_KP, CMD_KH, CMD_KT or CMD_KR)
+   @return uint8_t  1 if the command was performed, 0 if the button has no compiled keycodes
+   
+   performs a key command with the compiled keycodes of a button
+*/
+uint8_t replayKeyActions(uint8_t button, uint8_t cmd)
+{
+  uint8_t count = keyActionCount[button];
+  if (count == KEY_ACTIONS_NONE) return (0);
+
+  uint16_t * actions = keyActions + keyActionStart[button];
+  switch (cmd) {
+    case CMD_KW: for (uint8_t i = 0; i < count; i++) typeKey(actions[i]); break;
+    case CMD_KP: for (uint8_t i = 0; i < count; i++) pressKey(actions[i]);
+                 for (uint8_t i = 0; i < count; i++) releaseKey(actions[i]); 
+                 break;
+    case CMD_KH: for (uint8_t i = 0; i < count; i++) pressKey(actions[i]); break;
+    case CMD_KT: for (uint8_t i = 0; i < count; i++) toggleKey(actions[i]); break;
+    case CMD_KR: for (uint8_t i = 0; i < count; i++) releaseKey(actions[i]); break;
+    default: return (0);
+  }
+  return (1);
+}
+
 
 // here comes a character translation table - this works only for DE by now ...
 const int usToDE[] PROGMEM = 
@@ -22,6 +22,8 @@
 
 #define KEYBOARD_LAYOUT KBD_DE 
 #define HID_REPORT_KEY_COUNT 6
+#define KEY_ACTION_BUFFER_LEN 48    // number of compiled keycodes for all buttons of a slot
+#define KEY_ACTIONS_NONE    0xff    // button has no compiled keycodes (the keystring is used)
  
 #define MOD_ALTGR 256
 #define MOD_SHIFT 512
@@ -82,9 +84,11 @@
 #define KEY_F23 0xFA
 #define KEY_F24 0xFB
 
+#define MAX_KEYNAME_LEN 12          // maximum length of a key name in the keymap (without "KEY_")
+
 struct keymap_struct {
-  char *token;
-  int key;
+  char token[MAX_KEYNAME_LEN];
+  uint8_t key;
 };
 
 int getKeycode(char*);
@@ -93,5 +97,7 @@ void pressSingleKeys(char* text); // presses individual keys
 void releaseSingleKeys(char* text);  // releases individual keys
 void toggleSingleKeys(char* text); // toggles individual keys
 void release_all();            // releases all previously pressed keys and buttons
+void compileKeyActions();      // resolve the keystrings of all buttons to keycodes
+uint8_t replayKeyActions(uint8_t button, uint8_t cmd);  // perform a key command with the compiled keycodes
 
 #endif
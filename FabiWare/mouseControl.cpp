@@ -44,7 +44,7 @@ void updateMouse() {
     if (settings.ad && mouseMoveTimestamp) {
       if (millis() - mouseMoveTimestamp >= settings.ad) {
         #ifdef DEBUG_OUTPUT
-           Serial.println("Autodwell Click");
+           hostSerial.println("Autodwell Click");
         #endif
         leftMouseButton = 1;  leftClickRunning = DEFAULT_CLICK_TIME;
         mouseMoveTimestamp = 0;
@@ -12,6 +12,7 @@
 */
 
 #include "fabi.h"
+#include "binaryProtocol.h"
 
 char   cmdstring[MAX_CMDLEN];                 // buffer for incoming AT commands
 
@@ -67,6 +68,36 @@ uint8_t get_int(char * str, int16_t * result)
 }
 
 
+/**
+   @name get_hex
+   @param char * str
+   @param uint8_t * result
+   @param uint8_t maxlen
+   @return int16_t
+
+   translates a string of hex digits (two per byte, e.g. "0AFF") into bytes
+   which are stored into * result (at most maxlen bytes, may be the same buffer as str).
+   returns the number of bytes or -1 if the string contains invalid characters.
+*/
+int16_t get_hex(char * str, uint8_t * result, uint8_t maxlen)
+{
+    uint8_t len=0;
+    if (str==0) return(-1);
+    while (*str)
+    {
+      uint8_t b=0;
+      for (uint8_t i=0;i<2;i++) {
+        char c=charUp(*str++);
+        if ((c >= '0') && (c<='9')) b=(b<<4)+(c-'0');
+        else if ((c >= 'A') && (c<='F')) b=(b<<4)+(c-'A'+10);
+        else return(-1);
+      }
+      if (len >= maxlen) return(-1);
+      result[len++]=b;
+    }
+    return(len);
+}
+
 /**
    @name charUp
    @param char c
@@ -106,7 +137,7 @@ void strup (char * str)   // convert to upper case letters
    parse AT commands
    this function checks if a command string matches a valid AT-commands (command identifier with arguments of correct type, eg. "AT MX 10")
    if the AT command is valid, the function performCommand is called (executing the AT command)
-   if not, '?' is printed to the Serial interface
+   if not, '?' is printed to the hostSerial interface
 */
 void parseCommand (char * cmdstr)
 {
@@ -124,11 +155,8 @@ void parseCommand (char * cmdstr)
 
     if (strlen (actpos) > 1) {
                   
-      for (int i=0;(i<NUM_COMMANDS)&&(cmd==-1);i++)
-      {
-        if ((charUp(actpos[0]) == pgm_read_byte_near(&(atCommands[i].atCmd[0]))) &&
-            (charUp(actpos[1]) == pgm_read_byte_near(&(atCommands[i].atCmd[1])))) {
-
+      int8_t i = lookupCommand(charUp(actpos[0]), charUp(actpos[1]));
+      if (i >= 0) {
           // Serial.print ("partype="); Serial.println (pgm_read_byte_near(&(atCommands[i].partype)));
           switch (pgm_read_byte_near(&(atCommands[i].partype))) 
           {
@@ -139,12 +167,11 @@ void parseCommand (char * cmdstr)
              case PARTYPE_STRING: actpos+=3; cmd=i ;  break;
              default: cmd=i; actpos=0; break;
           }
-        }
-      }          
+      }
     } 
        
     if (cmd>-1)  performCommand(cmd,num,actpos,0);        
-    else Serial.println('?');
+    else hostSerial.println('?');
 }
 
 /**
@@ -156,13 +183,23 @@ void parseCommand (char * cmdstr)
    this function receives single bytes in order to assemble AT command strings
    an AT command must start with the sequence "AT " and additional characters for the AT command identifier and arguments, followed by '\n' or '\r'
    if an AT command was found, it is forwarded to the AT command parser (parseCommand)
-   if just "AT\r" is received, "OK" is printed to the Serial interface,
-   else,  '?' is printed to the Serial interface
+   if just "AT\r" is received, "OK" is printed to the hostSerial interface,
+   else,  '?' is printed to the hostSerial interface
+   bytes of binary frames (starting with FRAME_MAGIC) are forwarded to parseFrameByte()
+
+   a command can carry a tag (e.g. a sequence number): "AT#<tag> <command>"
+   all response lines of a tagged command start with "#<tag> ", 
+   if the command has no response, "#<tag> OK" is sent when it is finished
+   (for a macro: when the macro has been executed, see startMacro()).
 */
 void parseByte (int newByte)  // parse an incoming commandbyte from serial interface, perform command if valid
 {
    static uint8_t readstate=0;
    static uint8_t cmdlen=0;
+   static uint8_t taglen=0;
+   static char tag[MAX_TAG_LEN+1];
+
+      if ((readstate == 0) && parseFrameByte(newByte)) return;
   
       switch (readstate) {
         case 0: 
@@ -173,17 +210,32 @@ void parseByte (int newByte)  // parse an incoming commandbyte from serial inter
             break;
         case 2: 
                 if ((newByte==13) || (newByte==10))  // AT reply: "OK" 
-                {  Serial.println(F("OK"));  readstate=0;       }
-                else if (newByte==' ') { cmdlen=0; readstate++; } 
+                {  hostSerial.println(F("OK"));  readstate=0;       }
+                else if (newByte==' ') { tag[0]=0; cmdlen=0; readstate++; } 
+                else if (newByte=='#') { taglen=0; readstate=4; }
                 else goto err;
             break;
         case 3: 
                 if ((newByte==13) || (newByte==10))
-                {  cmdstring[cmdlen]=0;  parseCommand(cmdstring); 
-                  readstate=0; }
+                {  cmdstring[cmdlen]=0;
+                   if (tag[0]) hostSerial.setTag(tag);
+                   parseCommand(cmdstring); 
+                   if (tag[0]) {
+                     if (!hostSerial.tagUsed()) hostSerial.println(F("OK"));
+                     hostSerial.clearTag();
+                   }
+                   readstate=0; }
                 else if(cmdlen<MAX_CMDLEN-2) cmdstring[cmdlen++]=newByte; 
             break;   
+        case 4:   // command tag
+                tag[taglen]=0;
+                if ((newByte==13) || (newByte==10))
+                {  hostSerial.setTag(tag); hostSerial.println(F("OK")); hostSerial.clearTag(); readstate=0; }
+                else if ((newByte==' ') && taglen) { cmdlen=0; readstate=3; }
+                else if ((newByte!=' ') && (taglen<MAX_TAG_LEN)) tag[taglen++]=newByte;
+                else goto err;
+            break;
         default: 
-            err: Serial.println('?');readstate=0;
+            err: hostSerial.println('?');readstate=0;
    }
 }
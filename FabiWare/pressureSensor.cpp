@@ -0,0 +1,84 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: pressureSensor.cpp - interrupt driven sampling of the sip/puff pressure sensor
+
+     The ADC runs in free running mode (125kHz ADC clock, ~9600 conversions per second).
+     The conversion complete interrupt accumulates PRESSURE_OVERSAMPLING conversions
+     into one decimated 12 bit reading (~600 readings per second) and stores it in a
+     small ring buffer. The main loop only reads the mean of the buffer and never
+     waits for a conversion.
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "fabi.h"
+#include "buttons.h"
+#include "pressureSensor.h"
+
+volatile uint16_t pressureReadings[PRESSURE_BUFFER_LEN];  // decimated 12 bit readings, written by the ISR
+volatile uint8_t pressureReadingIndex = 0;                // next buffer position to be written by the ISR
+uint16_t adcSum = 0;                                      // sum of conversions for the current reading (ISR only)
+uint8_t adcCount = 0;                                     // number of conversions in adcSum (ISR only)
+
+/**
+   @name ADC_vect
+   @param none
+   @return none
+
+   ADC conversion complete interrupt: accumulates the conversions and
+   stores a decimated reading after PRESSURE_OVERSAMPLING conversions
+*/
+ISR(ADC_vect)
+{
+  adcSum += ADC;
+  if (++adcCount == PRESSURE_OVERSAMPLING) {
+    pressureReadings[pressureReadingIndex] = adcSum >> 2;   // 16 x 10 bit = 14 bit, decimate to 12 bit
+    pressureReadingIndex = (pressureReadingIndex + 1) & (PRESSURE_BUFFER_LEN - 1);
+    adcSum = 0;
+    adcCount = 0;
+  }
+}
+
+/**
+   @name initPressureSensor
+   @param none
+   @return none
+
+   fills the reading buffer with a first (blocking) conversion and
+   starts the ADC in free running mode with conversion complete interrupt
+*/
+void initPressureSensor()
+{
+  uint16_t initialReading = analogRead(PRESSURE_SENSOR_PIN) << 2;
+  for (uint8_t i = 0; i < PRESSURE_BUFFER_LEN; i++)
+    pressureReadings[i] = initialReading;
+
+  ADMUX = (1 << REFS0) | PRESSURE_ADC_CHANNEL;       // AVcc reference, right adjusted result
+  ADCSRB = 0;                                        // free running mode, MUX5 = 0
+  DIDR0 |= (1 << ADC7D);                             // disable digital input buffer of the sensor pin
+  ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIE)
+           | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);   // prescaler 128, start conversions
+}
+
+/**
+   @name getPressure
+   @param none
+   @return uint16_t  current pressure sensor value (12 bit, 0-4095)
+
+   returns the mean of the latest decimated readings, does not wait for the ADC
+*/
+uint16_t getPressure()
+{
+  uint16_t sum = 0;
+  noInterrupts();
+  for (uint8_t i = 0; i < PRESSURE_BUFFER_LEN; i++)
+    sum += pressureReadings[i];
+  interrupts();
+  return (sum / PRESSURE_BUFFER_LEN);
+}
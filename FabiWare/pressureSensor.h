@@ -0,0 +1,26 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: pressureSensor.h - interrupt driven sampling of the sip/puff pressure sensor
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+
+#ifndef _PRESSURESENSOR_H_
+#define _PRESSURESENSOR_H_
+
+#define PRESSURE_ADC_CHANNEL   7       // A0 (PF7) is ADC7 on the ATmega32u4
+#define PRESSURE_OVERSAMPLING 16       // 16 conversions per reading -> 2 additional bits (12 bit readings)
+#define PRESSURE_BUFFER_LEN    4       // number of readings which are averaged, must be a power of 2
+#define PRESSURE_MAX_VALUE  4095       // maximum value of a 12 bit reading
+
+void initPressureSensor();
+uint16_t getPressure();
+
+#endif
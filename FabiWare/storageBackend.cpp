@@ -0,0 +1,203 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: storageBackend.cpp - external I2C EEPROM and file storage for the slots
+     (the internal EEPROM is accessed via eepromWriter.cpp)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "fabi.h"
+#include "storageBackend.h"
+
+#if defined(STORAGE_I2C_EEPROM)
+
+#include <Wire.h>
+
+uint8_t pageBuffer[I2C_EEPROM_CHUNK];     // bytes which are not yet written (consecutive addresses of one page)
+storageAddress pageAddress = 0;           // EEPROM address of pageBuffer[0]
+uint8_t pageLen = 0;
+uint8_t readBuffer[I2C_EEPROM_CHUNK];     // the bytes of the last read transfer
+storageAddress readAddress = 0;           // EEPROM address of readBuffer[0]
+uint8_t readLen = 0;
+
+/**
+   @name deviceAddress
+   @param storageAddress address  EEPROM address
+   @return uint8_t  I2C address for this EEPROM address (small EEPROMs use the lower 3 bits as block number)
+*/
+uint8_t deviceAddress(storageAddress address)
+{
+#if I2C_EEPROM_ADDRESS_BYTES == 1
+  return (I2C_EEPROM_DEVICE | ((address >> 8) & 7));
+#else
+  return (I2C_EEPROM_DEVICE);
+#endif
+}
+
+/**
+   @name sendTransfer
+   @param storageAddress address  EEPROM address
+   @param const uint8_t * data  bytes which are written to the address
+   @param uint8_t len  number of bytes, 0 only sets the address (for a read)
+   @param uint8_t stop  0: no stop condition (a read follows)
+   @return uint8_t  0 if the EEPROM acknowledged the transfer
+
+   sends the address and the data. While the EEPROM is busy with a page write, it does not
+   acknowledge its address: the transfer is repeated until the page write is complete
+*/
+uint8_t sendTransfer(storageAddress address, const uint8_t * data, uint8_t len, uint8_t stop)
+{
+  uint32_t start = millis();
+  uint8_t result;
+  do {
+    Wire.beginTransmission(deviceAddress(address));
+#if I2C_EEPROM_ADDRESS_BYTES == 2
+    Wire.write((uint8_t) (address >> 8));
+#endif
+    Wire.write((uint8_t) address);
+    Wire.write(data, len);
+    result = Wire.endTransmission(stop);
+  } while ((result) && (millis() - start < I2C_EEPROM_WRITE_TIMEOUT));
+  return (result);
+}
+
+/**
+   @name storageInit
+   @param none
+   @return none
+*/
+void storageInit()
+{
+  Wire.begin();
+  Wire.setClock(400000);
+}
+
+/**
+   @name storageSync
+   @param none
+   @return none
+
+   writes the buffered bytes with one page write (the EEPROM needs up to 5 ms to store them,
+   this time is only waited for with the next access)
+*/
+void storageSync()
+{
+  if (!pageLen) return;
+  sendTransfer(pageAddress, pageBuffer, pageLen, 1);
+  pageLen = 0;
+}
+
+/**
+   @name storageFlush
+   @param none
+   @return none
+
+   writes the buffered bytes and waits until the EEPROM has stored them
+*/
+void storageFlush()
+{
+  storageSync();
+  sendTransfer(0, 0, 0, 1);
+}
+
+/**
+   @name storageRead
+   @param storageAddress address
+   @return uint8_t  the value of the address, including buffered writes
+
+   reads I2C_EEPROM_CHUNK bytes at once, so that sequential reads need one transfer per chunk
+*/
+uint8_t storageRead(storageAddress address)
+{
+  if ((storageAddress) (address - pageAddress) < pageLen)
+    return (pageBuffer[address - pageAddress]);
+
+  if ((storageAddress) (address - readAddress) >= readLen) {
+    readAddress = address;
+    readLen = I2C_EEPROM_CHUNK;
+    if (STORAGE_SIZE - address < readLen) readLen = STORAGE_SIZE - address;
+    sendTransfer(address, 0, 0, 0);                // repeated start, then read
+    Wire.requestFrom(deviceAddress(address), readLen);
+    for (uint8_t i = 0; i < readLen; i++)
+      readBuffer[i] = Wire.available() ? Wire.read() : 0xff;
+    for (uint8_t i = 0; i < pageLen; i++)          // bytes which are not yet written
+      if ((storageAddress) (pageAddress + i - readAddress) < readLen)
+        readBuffer[pageAddress + i - readAddress] = pageBuffer[i];
+  }
+  return (readBuffer[address - readAddress]);
+}
+
+/**
+   @name storageWrite
+   @param storageAddress address
+   @param uint8_t b
+   @return none
+
+   buffers the byte (if it differs from the current value): consecutive bytes of one page
+   are written together, see storageSync()
+*/
+void storageWrite(storageAddress address, uint8_t b)
+{
+  if (storageRead(address) == b) return;
+  if ((pageLen) && ((address != pageAddress + pageLen) || (pageLen == I2C_EEPROM_CHUNK) ||
+                    (address % I2C_EEPROM_PAGE_SIZE == 0)))
+    storageSync();
+  if (!pageLen) pageAddress = address;
+  pageBuffer[pageLen++] = b;
+  if ((storageAddress) (address - readAddress) < readLen)
+    readBuffer[address - readAddress] = b;
+}
+
+#elif defined(STORAGE_FILE)
+
+#include <stdio.h>
+
+FILE * storageFile = NULL;
+
+/**
+   @name storageInit
+   @param none
+   @return none
+
+   opens the storage file, a new file is filled with 0xff (like an erased EEPROM)
+*/
+void storageInit()
+{
+  if (storageFile) return;
+  storageFile = fopen(STORAGE_FILE, "r+b");
+  if (!storageFile) {
+    storageFile = fopen(STORAGE_FILE, "w+b");
+    for (uint32_t i = 0; i < STORAGE_SIZE; i++) fputc(0xff, storageFile);
+  }
+}
+
+uint8_t storageRead(storageAddress address)
+{
+  fseek(storageFile, address, SEEK_SET);
+  int c = fgetc(storageFile);
+  return ((c == EOF) ? 0xff : c);
+}
+
+void storageWrite(storageAddress address, uint8_t b)
+{
+  fseek(storageFile, address, SEEK_SET);
+  fputc(b, storageFile);
+}
+
+void storageSync()
+{
+  fflush(storageFile);
+}
+
+void storageFlush()
+{
+  fflush(storageFile);
+}
+
+#endif
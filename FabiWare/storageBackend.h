@@ -0,0 +1,98 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: storageBackend.h - byte access to the memory which holds the slots
+
+     The slot storage (eepromStorage.cpp) only uses storageRead(), storageWrite(), storageSync()
+     and storageFlush(). The backend is chosen at compile time, so there is no call overhead:
+       internal EEPROM (default)   1 KB, background writes, see eepromWriter.h
+       STORAGE_I2C_EEPROM <size>   external 24LCxx I2C EEPROM of <size> bytes (see fabi.h),
+                                   e.g. 32768 for a 24LC256 (up to 65536, 24LC512)
+       STORAGE_FILE "<name>"       a file of STORAGE_FILE_SIZE bytes, for builds on a PC
+                                   (e.g. g++ -DSTORAGE_FILE=\"fabi.eep\" ...)
+     STORAGE_SIZE, the address type and the page size of the I2C EEPROM are derived from the backend.
+     storageWrite() may buffer the data, but the bytes are always stored in the order of writing.
+     storageSync() starts writing the buffered bytes, storageFlush() waits until all bytes are stored.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+
+#ifndef _STORAGEBACKEND_H_
+#define _STORAGEBACKEND_H_
+
+#include "fabi.h"
+
+#if defined(STORAGE_I2C_EEPROM)
+
+  #define STORAGE_SIZE  (1UL * STORAGE_I2C_EEPROM)
+  #define I2C_EEPROM_DEVICE          0x50     // I2C address of the EEPROM (A0..A2 connected to GND)
+  #if STORAGE_I2C_EEPROM <= 2048              // 24LC01 .. 24LC16: one address byte, upper bits in the device address
+    #define I2C_EEPROM_ADDRESS_BYTES    1
+    #if STORAGE_I2C_EEPROM <= 256
+      #define I2C_EEPROM_PAGE_SIZE      8
+    #else
+      #define I2C_EEPROM_PAGE_SIZE     16
+    #endif
+  #else                                       // 24LC32 .. 24LC512: two address bytes
+    #define I2C_EEPROM_ADDRESS_BYTES    2
+    #if STORAGE_I2C_EEPROM <= 8192
+      #define I2C_EEPROM_PAGE_SIZE     32
+    #elif STORAGE_I2C_EEPROM <= 32768
+      #define I2C_EEPROM_PAGE_SIZE     64
+    #else
+      #define I2C_EEPROM_PAGE_SIZE    128
+    #endif
+  #endif
+  #define I2C_EEPROM_CHUNK      (32 - I2C_EEPROM_ADDRESS_BYTES)   // bytes per transfer (the Wire buffer has 32 bytes)
+  #define I2C_EEPROM_WRITE_TIMEOUT    10      // maximum duration of a page write in milliseconds
+
+#elif defined(STORAGE_FILE)
+
+  #ifndef STORAGE_FILE_SIZE
+    #define STORAGE_FILE_SIZE  1024
+  #endif
+  #define STORAGE_SIZE  (1UL * STORAGE_FILE_SIZE)
+
+#else
+
+  #define STORAGE_INTERNAL_EEPROM
+  #include "eepromWriter.h"
+  #define STORAGE_SIZE  (E2END + 1UL)
+
+#endif
+
+#if STORAGE_SIZE > 65536
+  #error "the slot storage supports up to 64 KB (record and image lengths have 16 bits)"
+#endif
+
+#if STORAGE_SIZE > 32768
+  typedef uint32_t storageAddress;     // log addresses go up to 2 * STORAGE_SIZE (see logAddress())
+#else
+  typedef uint16_t storageAddress;
+#endif
+
+#ifdef STORAGE_INTERNAL_EEPROM
+
+  inline void storageInit() { }
+  inline uint8_t storageRead(storageAddress address) { return (eepromRead(address)); }
+  inline void storageWrite(storageAddress address, uint8_t b) { eepromWrite(address, b); }
+  inline void storageSync() { }        // the EEPROM ready interrupt writes the queue
+  inline void storageFlush() { flushEEPROM(); }
+
+#else
+
+  void storageInit();
+  uint8_t storageRead(storageAddress address);
+  void storageWrite(storageAddress address, uint8_t b);
+  void storageSync();
+  void storageFlush();
+
+#endif
+
+#endif
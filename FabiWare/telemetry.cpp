@@ -0,0 +1,179 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: telemetry.cpp - binary live value stream and burst capture
+     (for the frame format and sample encoding see telemetry.h)
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "fabi.h"
+#include "binaryProtocol.h"
+#include "telemetry.h"
+
+struct telemetrySampleType {            // the live values of one tick
+  uint16_t pressure;
+  uint16_t buttonStates;
+  uint8_t  debouncerStates[TELEMETRY_STATE_BYTES];
+  uint8_t  slot;
+};
+
+static_assert(1 + TELEMETRY_SAMPLES_PER_FRAME * TELEMETRY_MAX_SAMPLE_LEN <= FRAME_MAX_PAYLOAD,
+              "burst frame exceeds the maximum frame payload");
+
+uint8_t telemetryInterval = 0;          // ticks between two FRAME_TELEMETRY samples, 0: stream stopped
+uint8_t telemetryCount = 0;             // ticks since the last FRAME_TELEMETRY sample
+uint8_t sampleNumber = 0;               // counts the ticks (wraps around)
+uint16_t streamPressure = 0;            // pressure of the last sample in the stream
+uint8_t streamResync = 1;               // next stream sample must be absolute
+
+#ifdef TELEMETRY_BURST
+#define BURST_IDLE    0
+#define BURST_CAPTURE 1
+#define BURST_SEND    2
+
+struct telemetrySampleType burstSamples[TELEMETRY_BURST_LEN];
+uint8_t burstState = BURST_IDLE;
+uint8_t burstLength = 0;                // number of samples to capture
+uint8_t burstPos = 0;                   // next sample to capture or send
+uint8_t burstFirstSample = 0;           // sample number of burstSamples[0]
+#endif
+
+/**
+   @name captureSample
+   @param struct telemetrySampleType * sample  receives the current live values
+   @return none
+*/
+void captureSample(struct telemetrySampleType * sample)
+{
+  sample->pressure = pressure;
+  sample->buttonStates = buttonStates;
+  memset(sample->debouncerStates, 0, TELEMETRY_STATE_BYTES);
+  for (uint8_t i = 0; i < NUMBER_OF_BUTTONS; i++)
+    sample->debouncerStates[i >> 2] |= (buttonDebouncers[i].pressState & 3) << ((i & 3) * 2);
+  sample->slot = actSlot;
+}
+
+/**
+   @name encodeSample
+   @param const struct telemetrySampleType * sample  the sample
+   @param uint16_t * lastPressure  pressure of the previous sample, is updated
+   @param uint8_t absolute  if 1, the pressure is sent as absolute value
+   @param uint8_t * data  receives the encoded sample (max. TELEMETRY_MAX_SAMPLE_LEN bytes)
+   @return uint8_t  length of the encoded sample
+*/
+uint8_t encodeSample(const struct telemetrySampleType * sample, uint16_t * lastPressure, uint8_t absolute, uint8_t * data)
+{
+  int16_t delta = (int16_t)sample->pressure - (int16_t)*lastPressure;
+  uint8_t len = 1;
+
+  if ((delta < -128) || (delta > 127)) absolute = 1;
+  data[0] = sample->slot & 0x7f;
+  if (absolute) {
+    data[0] |= TELEMETRY_ABSOLUTE;
+    data[len++] = sample->pressure & 0xff;
+    data[len++] = sample->pressure >> 8;
+  }
+  else data[len++] = (int8_t)delta;
+  *lastPressure = sample->pressure;
+
+  data[len++] = sample->buttonStates & 0xff;
+  data[len++] = sample->buttonStates >> 8;
+  memcpy(data + len, sample->debouncerStates, TELEMETRY_STATE_BYTES);
+  return (len + TELEMETRY_STATE_BYTES);
+}
+
+/**
+   @name startTelemetry
+   @param uint8_t interval  ticks between two samples (1: every tick), 0 stops the stream
+   @return none
+*/
+void startTelemetry(uint8_t interval)
+{
+  telemetryInterval = interval;
+  telemetryCount = 0;
+  streamResync = 1;
+}
+
+/**
+   @name startBurstCapture
+   @param uint8_t samples  number of samples (1 - TELEMETRY_BURST_LEN)
+   @return none
+
+   captures the live values at every tick into RAM, and sends them 
+   in FRAME_BURST frames when the capture is finished
+*/
+void startBurstCapture(uint8_t samples)
+{
+#ifdef TELEMETRY_BURST
+  burstLength = constrain(samples, 1, TELEMETRY_BURST_LEN);
+  burstPos = 0;
+  burstFirstSample = sampleNumber + 1;
+  burstState = BURST_CAPTURE;
+#else
+  hostSerial.println(F("E: not supported"));
+#endif
+}
+
+#ifdef TELEMETRY_BURST
+/**
+   @name sendBurstFrame
+   @param none
+   @return none
+
+   sends the next captured samples, or the final frame without samples
+*/
+void sendBurstFrame()
+{
+  uint8_t frame[1 + TELEMETRY_SAMPLES_PER_FRAME * TELEMETRY_MAX_SAMPLE_LEN];
+  uint16_t lastPressure = 0;
+  uint8_t len = 1;
+
+  frame[0] = burstFirstSample + burstPos;
+  for (uint8_t i = 0; (i < TELEMETRY_SAMPLES_PER_FRAME) && (burstPos < burstLength); i++, burstPos++)
+    len += encodeSample(&burstSamples[burstPos], &lastPressure, i == 0, frame + len);
+  sendFrame(FRAME_BURST, frame, len);
+  if (len == 1) burstState = BURST_IDLE;
+}
+#endif
+
+/**
+   @name updateTelemetry
+   @param none
+   @return none
+
+   sends the stream sample and captures or sends the burst, called once per tick
+*/
+void updateTelemetry()
+{
+  sampleNumber++;
+
+  if (telemetryInterval && (++telemetryCount >= telemetryInterval)) {
+    struct telemetrySampleType sample;
+    uint8_t frame[1 + TELEMETRY_MAX_SAMPLE_LEN];
+
+    telemetryCount = 0;
+    captureSample(&sample);
+    frame[0] = sampleNumber;
+    uint8_t len = 1 + encodeSample(&sample, &streamPressure, streamResync, frame + 1);
+    hostSerial.beginTelemetry();
+    sendFrame(FRAME_TELEMETRY, frame, len);
+    streamResync = hostSerial.endTelemetry();
+  }
+
+#ifdef TELEMETRY_BURST
+  if (burstState == BURST_CAPTURE) {
+    captureSample(&burstSamples[burstPos]);
+    if (++burstPos == burstLength) {
+      burstPos = 0;
+      burstState = BURST_SEND;
+    }
+  }
+  else if (burstState == BURST_SEND) sendBurstFrame();   // one frame per tick
+#endif
+}
@@ -0,0 +1,43 @@
+/* 
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands  
+     More Information: https://github.com/asterics/FABI
+
+     Module: telemetry.h - binary live value stream and burst capture
+
+     The telemetry is sent in binary frames (see binaryProtocol.h):
+       FRAME_TELEMETRY  sample number (uint8, counts every tick), one sample
+       FRAME_BURST      number of the first sample (uint8), up to TELEMETRY_SAMPLES_PER_FRAME samples,
+                        the burst ends with a frame without samples
+
+     Sample encoding:
+       header   bit 7: TELEMETRY_ABSOLUTE, bits 0-6: slot number (1 = first slot)
+       pressure uint16 if TELEMETRY_ABSOLUTE is set, else int8 difference to the previous sample
+       buttons  buttonStates (uint16, bit 0 = button 1)
+       states   debouncer state of every button (2 bits each, BUTTONSTATE_xxx, button 1 in bits 0-1)
+
+     In a FRAME_BURST, the first sample is always absolute. In the FRAME_TELEMETRY stream, the pressure
+     is absolute after a frame was dropped (host too slow, see hostSerial.h), so a gap in the sample 
+     numbers tells the host to wait for the next absolute sample.
+        
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#define TELEMETRY_ABSOLUTE          0x80  // sample header flag: the pressure is sent as absolute value
+#define TELEMETRY_STATE_BYTES       ((NUMBER_OF_BUTTONS * 2 + 7) / 8)
+#define TELEMETRY_MAX_SAMPLE_LEN    (5 + TELEMETRY_STATE_BYTES)
+#define TELEMETRY_SAMPLES_PER_FRAME 8     // samples in one FRAME_BURST
+#define TELEMETRY_BURST_LEN        64     // maximum number of samples of a burst capture
+
+void startTelemetry(uint8_t interval);    // send a sample every <interval> ticks, 0: stop
+void startBurstCapture(uint8_t samples);  // capture samples at every tick, send them afterwards
+void updateTelemetry();                   // called every tick, after the buttons were updated
+
+#endif
@@ -0,0 +1,81 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: command_lookup.cpp - benchmark: AT command lookup (perfect hash, commands.cpp) versus a linear scan of the command list
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "Arduino.h"
+#include "fabi.h"
+#include "timing.h"
+
+// the identifiers of atCommands[], read from the source (atCommands[] is local to commands.cpp)
+static char names[NUM_COMMANDS][3];
+static int numNames = 0;
+
+static int loadCommandNames()
+{
+  FILE * f = fopen(FW_DIR "/commands.cpp", "r");
+  if (!f) {
+    perror(FW_DIR "/commands.cpp");
+    return 0;
+  }
+  char line[160];
+  uint8_t inTable = 0;
+  while (fgets(line, sizeof(line), f)) {
+    if (strstr(line, "atCommands[] PROGMEM")) inTable = 1;
+    else if ((inTable) && (!strncmp(line, "};", 2))) break;
+    else if (inTable) {
+      for (char * entry = strstr(line, "{\""); entry && (numNames < NUM_COMMANDS); entry = strstr(entry + 2, "{\"")) {
+        names[numNames][0] = entry[2];
+        names[numNames][1] = entry[3];
+        names[numNames++][2] = 0;
+      }
+    }
+  }
+  fclose(f);
+  return numNames;
+}
+
+/**
+   the previous implementation: compares the identifier with every entry until it is found
+*/
+static int linearLookup(const char * name)
+{
+  for (int i = 0; i < numNames; i++)
+    if (!strncmp(name, names[i], 2)) return i;
+  return -1;
+}
+
+int main()
+{
+  if (loadCommandNames() != NUM_COMMANDS) {
+    printf("found %d of %d commands in commands.cpp\n", numNames, NUM_COMMANDS);
+    return 1;
+  }
+  int wrong = 0;
+  for (int i = 0; i < numNames; i++)
+    if ((lookupCommand(names[i][0], names[i][1]) != i) || (linearLookup(names[i]) != i)) wrong++;
+  printf("%d commands, wrong index: %d, unknown command: %d\n", numNames, wrong, lookupCommand('Z', 'Z'));
+
+  volatile int sink = 0;
+  const long repeat = 100000;
+  double linear = nsPerCall(repeat, [&]() { for (int i = 0; i < numNames; i++) sink += linearLookup(names[i]); }) / numNames;
+  double hash = nsPerCall(repeat, [&]() { for (int i = 0; i < numNames; i++) sink += lookupCommand(names[i][0], names[i][1]); }) / numNames;
+  double linearWorst = 0, hashWorst = 0;
+  for (int i = 0; i < numNames; i++) {
+    double t = nsPerCall(repeat, [&]() { sink += linearLookup(names[i]); });
+    if (t > linearWorst) linearWorst = t;
+    t = nsPerCall(repeat, [&]() { sink += lookupCommand(names[i][0], names[i][1]); });
+    if (t > hashWorst) hashWorst = t;
+  }
+  printf("linear scan:  %.1f ns per lookup, worst %.1f ns\n", linear, linearWorst);
+  printf("perfect hash: %.1f ns per lookup, worst %.1f ns\n", hash, hashWorst);
+  return 0;
+}
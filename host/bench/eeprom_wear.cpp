@@ -0,0 +1,91 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: eeprom_wear.cpp - benchmark: bytes written per save and wear leveling of the slot log (internal EEPROM)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include "eepromStorage.h"
+#include "settings.h"
+
+extern storageAddress liveBytes;
+
+int main()
+{
+  int n = loadSettings();
+  if (!n) return 1;
+  pinsHigh();
+  setup();
+  runFor(20);
+  cmd("AT BM 1"); cmd("AT KW old"); cmd("AT SA one");
+  cmd("AT BM 1"); cmd("AT KW slot two text"); cmd("AT SA two");
+
+  // an edit of one slot
+  cmd("AT LO one");
+  const char * edits[] = { "AT KW a longer text", "AT KW old", "AT KW new" };
+  for (int i = 0; i < 3; i++) {
+    cmd("AT BM 1");
+    cmd(edits[i]);
+    flushEEPROM();                  // writes of the previous save
+    unsigned long writes = EEPROM.writes;
+    saveToEEPROM("one");
+    flushEEPROM();
+    printf("edit save (%s): %lu bytes written\n", edits[i], EEPROM.writes - writes);
+  }
+
+  // wear leveling: 500 saves of two slots
+  memset(EEPROM.wear, 0, sizeof(EEPROM.wear));
+  unsigned long writes = EEPROM.writes;
+  for (int i = 0; i < 500; i++) {
+    char line[40];
+    snprintf(line, sizeof(line), "AT KW t%d", i % 200);
+    cmd("AT BM 1");
+    cmd(line);
+    saveToEEPROM(i & 1 ? "one" : "two");
+    clearOut();
+  }
+  flushEEPROM();
+  unsigned long minWear = ~0UL, maxWear = 0, used = 0;
+  for (unsigned i = 0; i < LOG_SIZE; i++) {
+    if (EEPROM.wear[i]) used++;
+    if (EEPROM.wear[i] < minWear) minWear = EEPROM.wear[i];
+    if (EEPROM.wear[i] > maxWear) maxWear = EEPROM.wear[i];
+  }
+  printf("500 saves: %.1f bytes written per save, wear: max %lu writes/cell, min %lu, %lu cells used\n",
+         (EEPROM.writes - writes) / 500.0, maxWear, minWear, used);
+
+  // the first 18 slots of the settings files, saved twice
+  cmd("AT DE");
+  writes = EEPROM.writes;
+  int saved = 0;
+  for (int i = 0; (i < n) && (i < 18); i++) {
+    char name[16];
+    cmd("AT LO default");
+    for (int l = 0; l < setSlots[i].numLines; l++) cmd(setSlots[i].lines[l]);
+    clearOut();
+    snprintf(name, sizeof(name), "s%d", i);
+    if (!saveToEEPROM(name)) break;
+    saved++;
+  }
+  flushEEPROM();
+  printf("%d typical slots: %lu bytes written, %u bytes live\n", saved, EEPROM.writes - writes, (unsigned) liveBytes);
+  writes = EEPROM.writes;
+  for (int i = 0; i < saved; i++) {
+    char line[24];
+    snprintf(line, sizeof(line), "AT LO s%d", i);
+    cmd(line);
+    clearOut();
+    saveToEEPROM(line + 6);
+  }
+  flushEEPROM();
+  printf("saving them again (unchanged): %lu bytes written\n", EEPROM.writes - writes);
+  return 0;
+}
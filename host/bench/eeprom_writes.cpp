@@ -0,0 +1,52 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: eeprom_writes.cpp - benchmark: EEPROM bytes written inside a save versus in the background (EEPROM ready interrupt)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include "eepromStorage.h"
+
+int main()
+{
+  const char * texts[] = { "hello world", "KEY_CTRL KEY_C ", "another text", "KEY_ALT KEY_TAB " };
+  unsigned long maxBlocking = 0, sumBlocking = 0, sumTotal = 0, maxTime = 0, sumTime = 0;
+  int saves = 0;
+  pinsHigh();
+  setup();
+  runFor(2000);
+  for (int i = 0; i < 40; i++) {
+    char line[40];
+    cmd("AT BM 1");
+    snprintf(line, sizeof(line), "AT KW %s%d", texts[i & 3], i);
+    cmd(line);
+    cmd("AT BM 2");
+    cmd(i & 1 ? "AT KP KEY_A" : "AT KH KEY_B");
+    unsigned long blocking = eeSyncWrites, writes = EEPROM.writes;
+    Serial.feed(i & 1 ? "AT SA s1\r" : "AT SA s2\r");
+    uint32_t start = mock_micros;
+    loop();                         // the save itself: writes which are started while the loop waits
+    unsigned long time = mock_micros - start;
+    blocking = eeSyncWrites - blocking;
+    if (time > maxTime) maxTime = time;
+    sumTime += time;
+    runFor(1000);                   // background writes from the EEPROM ready interrupt
+    if (blocking > maxBlocking) maxBlocking = blocking;
+    sumBlocking += blocking;
+    sumTotal += EEPROM.writes - writes;
+    saves++;
+  }
+  printf("%d saves: %.1f bytes written per save, %.1f of them started by the loop (max %lu, queue %d bytes)\n",
+         saves, sumTotal / (double) saves, sumBlocking / (double) saves, maxBlocking, EEPROM_QUEUE_LEN);
+  printf("loop blocked per save: %.1f ms, max %.1f ms (mock clock, 3.4 ms per EEPROM write)\n",
+         sumTime / 1000.0 / saves, maxTime / 1000.0);
+  return 0;
+}
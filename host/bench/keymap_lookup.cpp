@@ -0,0 +1,83 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: keymap_lookup.cpp - benchmark: key name lookup (binary search, keys.cpp) versus a linear scan of the keymap
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "Arduino.h"
+#include "fabi.h"
+#include "keys.h"
+#include "timing.h"
+
+#define MAX_NAMES 200
+
+// the names of keymap[], read from the source (keymap[] is local to keys.cpp)
+static char names[MAX_NAMES][MAX_KEYNAME_LEN + 5];
+static int numNames = 0;
+
+static int loadKeyNames()
+{
+  FILE * f = fopen(FW_DIR "/keys.cpp", "r");
+  if (!f) {
+    perror(FW_DIR "/keys.cpp");
+    return 0;
+  }
+  char line[120];
+  uint8_t inKeymap = 0;
+  while (fgets(line, sizeof(line), f)) {
+    if (strstr(line, "keymap[] PROGMEM")) inKeymap = 1;
+    else if ((inKeymap) && (!strncmp(line, "};", 2))) break;
+    else if (inKeymap) {
+      char * start = strstr(line, "{\"");
+      if ((!start) || (numNames >= MAX_NAMES)) continue;
+      start += 2;
+      int len = strchr(start, '"') - start;
+      snprintf(names[numNames++], sizeof(names[0]), "KEY_%.*s", len, start);
+    }
+  }
+  fclose(f);
+  return numNames;
+}
+
+/**
+   the previous implementation: compares the name with every entry until it is found
+*/
+static int linearLookup(const char * name)
+{
+  if (strncmp(name, "KEY_", 4)) return -1;
+  for (int i = 0; i < numNames; i++)
+    if (!strcmp(name + 4, names[i] + 4)) return i;
+  return -1;
+}
+
+int main()
+{
+  if (!loadKeyNames()) return 1;
+  int missing = 0;
+  for (int i = 0; i < numNames; i++)
+    if ((!getKeycode(names[i])) || (linearLookup(names[i]) != i)) missing++;
+  char unknown[] = "KEY_NOPE";
+  printf("%d key names, not found: %d, unknown name: %d\n", numNames, missing, getKeycode(unknown));
+
+  volatile int sink = 0;
+  const long repeat = 20000;
+  double linear = nsPerCall(repeat, [&]() { for (int i = 0; i < numNames; i++) sink += linearLookup(names[i]); }) / numNames;
+  double binary = nsPerCall(repeat, [&]() { for (int i = 0; i < numNames; i++) sink += getKeycode(names[i]); }) / numNames;
+  double linearWorst = 0, binaryWorst = 0;
+  for (int i = 0; i < numNames; i++) {
+    double t = nsPerCall(repeat, [&]() { sink += linearLookup(names[i]); });
+    if (t > linearWorst) linearWorst = t;
+    t = nsPerCall(repeat, [&]() { sink += getKeycode(names[i]); });
+    if (t > binaryWorst) binaryWorst = t;
+  }
+  printf("linear scan:   %.1f ns per lookup, worst %.1f ns\n", linear, linearWorst);
+  printf("binary search: %.1f ns per lookup, worst %.1f ns\n", binary, binaryWorst);
+  return 0;
+}
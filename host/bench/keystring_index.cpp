@@ -0,0 +1,74 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: keystring_index.cpp - benchmark: keystring offset table (buttons.cpp) versus the previous linear walk through the buffer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "Arduino.h"
+#include "fabi.h"
+#include "timing.h"
+
+#define BUTTONS NUMBER_OF_BUTTONS
+
+// the previous implementation: the keystrings follow each other in the buffer,
+// a keystring is found by skipping all keystrings before it
+static char linearBuffer[KEYSTRING_BUFFER_LEN];
+
+static char * linearGet(uint8_t button)
+{
+  char * s = linearBuffer;
+  for (int i = 0; i < button; i++) s += strlen(s) + 1;
+  return s;
+}
+
+static uint16_t linearUsage(uint8_t button)
+{
+  uint16_t sum = 0;
+  for (int i = button; i < BUTTONS; i++) sum += strlen(linearGet(i)) + 1;
+  return sum;
+}
+
+static void linearSet(uint8_t button, const char * text)
+{
+  if (linearUsage(0) - strlen(linearGet(button)) + strlen(text) >= KEYSTRING_BUFFER_LEN) return;
+  if (button < BUTTONS - 1) {
+    int16_t delta = strlen(text) - strlen(linearGet(button));
+    memmove(linearGet(button + 1) + delta, linearGet(button + 1), linearUsage(button + 1));
+  }
+  strcpy(linearGet(button), text);
+}
+
+int main()
+{
+  // a full slot: 13 keystrings of 21 characters (286 bytes)
+  char texts[BUTTONS][22];
+  for (int i = 0; i < BUTTONS; i++) {
+    memset(texts[i], 'a' + i, 21);
+    texts[i][21] = 0;
+  }
+  volatile int sink = 0;
+
+  double linear = nsPerCall(20000, [&]() {
+    memset(linearBuffer, 0, BUTTONS);
+    for (int i = 0; i < BUTTONS; i++) linearSet(i, texts[i]);
+    for (int i = 0; i < BUTTONS; i++) sink += *linearGet(i);
+  });
+  double table = nsPerCall(20000, [&]() {
+    memset(keystringBuffer, 0, BUTTONS);
+    indexKeystrings();
+    for (int i = 0; i < BUTTONS; i++) setKeystring(i, texts[i]);
+    for (int i = 0; i < BUTTONS; i++) sink += *getKeystring(i);
+  });
+  printf("slot upload and fetch of %d keystrings (%d bytes):\n", BUTTONS, linearUsage(0));
+  printf("  linear walk:  %.2f us\n", linear / 1000);
+  printf("  offset table: %.2f us\n", table / 1000);
+  printf("same buffer content: %s\n", memcmp(linearBuffer, keystringBuffer, linearUsage(0)) ? "no" : "yes");
+  return 0;
+}
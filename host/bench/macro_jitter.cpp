@@ -0,0 +1,86 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: macro_jitter.cpp - benchmark: loop ticks and tick periods while a macro runs (build with LOOP_PROFILER)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+
+#define RUN_TIME 1000    // duration of every run in milliseconds (mock clock)
+
+// the commands of the macro, the blocking run executes them one after the other like the old macro engine
+static const char * macroSteps[] = { "KP KEY_A", "WA 200", "KW hello world", "WA 200", "MX 5", "WA 100", "KP KEY_B" };
+#define MACRO_STEPS (sizeof(macroSteps) / sizeof(macroSteps[0]))
+
+static uint32_t runStart;
+
+/**
+   prints the ticks per second, the tick overruns, the longest tick period and the longest
+   MACRO stage of the profiler report (AT PR) since the previous call, then resets the profiler
+*/
+static void printProfile(const char * title)
+{
+  unsigned macroMax = 0, ticks = 0, overruns = 0, period, worst = 0;
+  uint32_t elapsed = mock_micros - runStart;
+  clearOut();
+  cmd("AT PR");
+  runStart = mock_micros;
+  for (char * line = strtok(Serial.out, "\n"); line; line = strtok(NULL, "\n")) {
+    sscanf(line, "PROFILE MACRO min:%*u mean:%*u max:%u", &macroMax);
+    sscanf(line, "TICKS:%u OVERRUNS:%u", &ticks, &overruns);
+    if ((sscanf(line, "WORST period:%u", &period) == 1) && (period > worst)) worst = period;
+  }
+  printf("%-17s %5.1f ticks/s  %3u overruns  longest period %5u us  longest MACRO stage %3u us\n",
+         title, ticks * 1e6 / elapsed, overruns, worst, macroMax);
+  clearOut();
+}
+
+int main()
+{
+  char macro[MAX_CMDLEN] = "AT MA ";
+  for (unsigned i = 0; i < MACRO_STEPS; i++) {
+    if (i) strcat(macro, ";");
+    strcat(macro, macroSteps[i]);
+  }
+
+  pinsHigh();
+  setup();
+  runFor(50);
+  cmd("AT AP 1");
+  cmd("AT BM 1");
+  cmd(macro);
+  runFor(50);
+
+  cmd("AT PR");
+  runStart = mock_micros;
+  runFor(RUN_TIME);
+  printProfile("idle");
+
+  // background macro engine: one macro command per tick, AT WA does not block the loop
+  pressPin(2, 20);
+  runFor(RUN_TIME - 40);
+  printProfile("background macro");
+
+  // blocking execution of the same commands within one tick (AT WA calls delay())
+  // (the profiler limits a period to 65535 us, the stall is measured separately)
+  runFor(10);
+  uint32_t start = mock_micros;
+  for (unsigned i = 0; i < MACRO_STEPS; i++) {
+    char step[MAX_MACROCMD_LEN];
+    strcpy(step, macroSteps[i]);
+    parseCommand(step);
+  }
+  uint32_t stall = mock_micros - start;
+  runFor(RUN_TIME - 10 - stall / 1000);
+  printProfile("blocking macro");
+  printf("blocking macro: loop stalled for %lu us\n", (unsigned long) stall);
+  return 0;
+}
@@ -0,0 +1,67 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: pin_snapshot.cpp - benchmark: port snapshot of the switch inputs versus one digitalRead() per switch
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include "timing.h"
+
+extern int8_t input_map[];
+extern uint8_t NUMBER_OF_PHYSICAL_BUTTONS;
+
+// digitalRead() of the Arduino AVR core (wiring_digital.c) with the PROGMEM pin tables
+// of the Leonardo variant: three table lookups, a PWM check and the register read per pin
+#define NOT_ON_TIMER 0
+static const uint8_t corePinToPort[24] PROGMEM = { 4, 4, 4, 4, 4, 3, 4, 5, 2, 2, 2, 2, 4, 3, 2, 2, 2, 2, 6, 6, 6, 6, 6, 6 };
+static const uint8_t corePinToBit[24] PROGMEM = { 2, 3, 1, 0, 4, 6, 7, 6, 4, 5, 6, 7, 6, 7, 3, 1, 2, 0, 7, 6, 5, 4, 1, 0 };
+static const uint8_t corePinToTimer[24] PROGMEM = { 0, 0, 0, 1, 0, 2, 3, 0, 0, 4, 5, 6, 0, 7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static volatile uint8_t timerControl[8];
+
+static void turnOffPWM(uint8_t timer)
+{
+  timerControl[timer] &= ~0x80;
+}
+
+static int coreDigitalRead(uint8_t pin)
+{
+  uint8_t timer = pgm_read_byte(corePinToTimer + pin);
+  uint8_t bit = 1 << pgm_read_byte(corePinToBit + pin);
+  uint8_t port = pgm_read_byte(corePinToPort + pin);
+  if (timer != NOT_ON_TIMER) turnOffPWM(timer);
+  return (*portInputRegister(port) & bit) ? HIGH : LOW;
+}
+
+static uint16_t readButtonsDigitalRead()
+{
+  uint16_t pressed = 0;
+  for (uint8_t i = 0; i < NUMBER_OF_PHYSICAL_BUTTONS; i++)
+    if (coreDigitalRead(input_map[i]) == LOW) pressed |= (1 << i);
+  return pressed;
+}
+
+int main()
+{
+  pinsHigh();
+  setup();
+  volatile uint16_t sink = 0;
+  int mismatches = 0;
+  for (int r = 0; r < 1000; r++) {
+    for (int pin = 0; pin < 24; pin++) mockSetPin(pin, rand() & 1);
+    if (readButtonPins() != readButtonsDigitalRead()) mismatches++;
+  }
+  double loop = nsPerCall(10000000, [&]() { sink += readButtonsDigitalRead(); });
+  double snapshot = nsPerCall(10000000, [&]() { sink += readButtonPins(); });
+  printf("%d switches, %d mismatches in 1000 rounds\n", NUMBER_OF_PHYSICAL_BUTTONS, mismatches);
+  printf("digitalRead() loop: %.1f ns per scan\n", loop);
+  printf("port snapshot:      %.1f ns per scan\n", snapshot);
+  return 0;
+}
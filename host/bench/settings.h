@@ -0,0 +1,72 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: settings.h - benchmarks: reads the slots of the settings files (Settings/<name>.set)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#ifndef _SETTINGS_H_
+#define _SETTINGS_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <glob.h>
+
+#define MAX_SET_SLOTS  100
+#define MAX_SET_LINES   64
+#define MAX_SET_LINE    80
+
+/**
+   a slot of a settings file: its name and AT commands (the lines after "Slot:<name>")
+*/
+struct setSlot {
+  char file[MAX_SET_LINE];
+  char name[MAX_SET_LINE];
+  char lines[MAX_SET_LINES][MAX_SET_LINE];
+  int numLines;
+};
+
+static setSlot setSlots[MAX_SET_SLOTS];
+
+/**
+   reads the slots of all settings files (SETTINGS_DIR/<name>.set), returns the number of slots
+*/
+static int loadSettings()
+{
+  glob_t files;
+  int n = 0;
+  if (glob(SETTINGS_DIR "/*.set", 0, 0, &files)) {
+    fprintf(stderr, "no settings files in " SETTINGS_DIR "\n");
+    return 0;
+  }
+  for (size_t f = 0; f < files.gl_pathc; f++) {
+    FILE * file = fopen(files.gl_pathv[f], "r");
+    if (!file) continue;
+    const char * fileName = strrchr(files.gl_pathv[f], '/') + 1;
+    char line[MAX_SET_LINE];
+    setSlot * slot = 0;
+    while (fgets(line, sizeof(line), file)) {
+      line[strcspn(line, "\r\n")] = 0;
+      if (!strncmp(line, "Slot:", 5)) {
+        if (n >= MAX_SET_SLOTS) break;
+        slot = &setSlots[n++];
+        snprintf(slot->file, sizeof(slot->file), "%s", fileName);
+        snprintf(slot->name, sizeof(slot->name), "%s", line + 5);
+        slot->numLines = 0;
+      }
+      else if ((slot) && (!strncmp(line, "AT ", 3)) && (slot->numLines < MAX_SET_LINES))
+        strcpy(slot->lines[slot->numLines++], line);
+    }
+    fclose(file);
+  }
+  globfree(&files);
+  return n;
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: slot_sizes.cpp - benchmark: record sizes of the slots in the settings files (Settings/<name>.set) and the number of slots which fit
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include "eepromStorage.h"
+#include "settings.h"
+
+storageAddress encodedSlotLength();
+
+/**
+   loads the "default" slot, then applies the AT commands of a settings slot
+*/
+static void applySlot(const setSlot & slot)
+{
+  cmd("AT LO default");
+  for (int i = 0; i < slot.numLines; i++) cmd(slot.lines[i]);
+  clearOut();
+}
+
+int main()
+{
+  static int lenOld[MAX_SET_SLOTS], lenNew[MAX_SET_SLOTS];
+  int n = loadSettings();
+  if (!n) return 1;
+  pinsHigh();
+  setup();
+  runFor(20);
+
+  long sumOld = 0, sumNew = 0;
+  for (int i = 0; i < n; i++) {
+    applySlot(setSlots[i]);
+    strcpy(settings.slotname, setSlots[i].name);
+    uint16_t keystrings = keystringMemUsage(0);
+    // the original format with the type sizes of the ATmega32u4: settings, 4 bytes per button, keystrings
+    lenOld[i] = 40 + NUMBER_OF_BUTTONS * 4 + keystrings;
+    lenNew[i] = encodedSlotLength();
+    sumOld += lenOld[i];
+    sumNew += lenNew[i];
+    printf("%-36s %-12s keystrings %3d  old %3d  new %3d\n", setSlots[i].file, setSlots[i].name, keystrings, lenOld[i], lenNew[i]);
+  }
+  printf("%d slots: mean old %.1f bytes, mean new %.1f bytes (incl. %d bytes record overhead)\n",
+         n, sumOld / (double) n, sumNew / (double) n, RECORD_OVERHEAD);
+
+  // capacity: the "default" slot, then the settings slots (repeated) until the EEPROM is full
+  int oldFree = EEPROM_TOP_ADDRESS - 1 - (40 + NUMBER_OF_BUTTONS * 4 + NUMBER_OF_BUTTONS);
+  int oldCount = 0;
+  while (lenOld[oldCount % n] <= oldFree) oldFree -= lenOld[oldCount++ % n];
+  int newCount = 0;
+  while (newCount < 100) {
+    char name[16];
+    applySlot(setSlots[newCount % n]);
+    snprintf(name, sizeof(name), "s%d", newCount);
+    if (!saveToEEPROM(name)) break;
+    newCount++;
+  }
+  printf("typical slots which fit besides \"default\": original format %d, compact log %d\n", oldCount, newCount);
+
+  int bad = 0;
+  for (int i = 0; i < newCount; i++) {
+    char line[24];
+    snprintf(line, sizeof(line), "AT LO s%d", i);
+    cmd(line);
+    clearOut();
+    if (strcmp(settings.slotname, line + 6)) bad++;
+  }
+  printf("reload check bad=%d\n", bad);
+  return 0;
+}
@@ -0,0 +1,74 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: slot_switch.cpp - benchmark: storage accesses and duration of a slot change (AT NE)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include "Wire.h"
+
+/**
+   storage accesses: EEPROM reads or I2C transfers
+*/
+static unsigned long storageAccesses()
+{
+#ifdef STORAGE_I2C_EEPROM
+  return I2CEEPROM.transfers;
+#else
+  return EEPROM.reads;
+#endif
+}
+
+int main()
+{
+  const char * names[4] = { "write", "game", "media", "browse" };
+  pinsHigh();
+  setup();
+  runFor(20);
+  for (int s = 0; s < 4; s++) {
+    char line[32];
+    cmd("AT BM 1"); cmd("AT KW hello world");
+    cmd("AT BM 2"); cmd("AT KP KEY_CTRL KEY_C");
+    cmd("AT BM 3"); cmd("AT KP KEY_CTRL KEY_V");
+    cmd("AT BM 4"); cmd("AT MX 5");
+    cmd("AT BM 5"); cmd("AT TS 300");
+    snprintf(line, sizeof(line), "AT SA %s", names[s]);
+    cmd(line);
+  }
+  runFor(50);
+
+  // every second NE follows the previous one immediately, the others after 20 ms of idle loop
+  unsigned long count[2] = { 0, 0 }, accesses[2] = { 0, 0 }, duration[2] = { 0, 0 };
+  for (int i = 0; i < 40; i++) {
+    int idle = (i & 1) == 0;
+    unsigned long a = storageAccesses();
+    uint32_t start = mock_micros;
+    performCommand(CMD_NE, 0, 0, 0);
+    duration[idle] += mock_micros - start;
+    accesses[idle] += storageAccesses() - a;
+    count[idle]++;
+    if (!idle) runFor(20);
+  }
+#ifdef STORAGE_I2C_EEPROM
+  const char * storage = "I2C transfers";
+#else
+  const char * storage = "EEPROM reads";
+#endif
+  for (int idle = 1; idle >= 0; idle--)
+    printf("%s: %lu NE, %.1f %s per NE, %.0f us per NE (mock clock)\n", idle ? "after idle" : "back to back",
+           count[idle], (double) accesses[idle] / count[idle], storage, (double) duration[idle] / count[idle]);
+#ifdef LOOP_PROFILER
+  clearOut();
+  cmd("AT PR");
+  printOut();
+#endif
+  return 0;
+}
@@ -0,0 +1,29 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: timing.h - benchmarks: wall clock timing of code on the host (x86, not the ATmega32u4)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#ifndef _TIMING_H_
+#define _TIMING_H_
+
+#include <chrono>
+
+/**
+   returns the mean duration of one call of f() in nanoseconds (runs f() repeat times)
+*/
+template <typename F> double nsPerCall(long repeat, F f)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (long r = 0; r < repeat; r++) f();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / repeat;
+}
+
+#endif
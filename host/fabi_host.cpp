@@ -0,0 +1,71 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: fabi_host.cpp - host build: runs the firmware with stdin/stdout as serial port
+
+     usage: fabi_host [eeprom file]      (default: fabi.eep, created if it does not exist)
+     AT commands are read from stdin (e.g. "echo 'AT ID' | ./fabi_host" or interactively,
+     or a pty: socat pty,link=/tmp/fabi,raw EXEC:./fabi_host), the responses go to stdout,
+     the HID reports to stderr. The virtual clock runs in real time while stdin is open;
+     after the end of the input, the firmware runs for one more (virtual) second.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "Arduino.h"
+#include "EEPROM.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define LOOP_STEP       100       // time between two loop() calls in microseconds
+#define RUN_AFTER_EOF   1000000   // run time after the end of the input in microseconds
+
+void setup();
+void loop();
+
+extern char hidlog[];
+extern int hidlen;
+
+int main(int argc, char ** argv)
+{
+  mockAttachEEPROM(argc > 1 ? argv[1] : "fabi.eep");
+  for (int i = 0; i < MOCK_PINS; i++) mockSetPin(i, 1);     // switches released (pull-ups)
+  fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+  setup();
+
+  uint32_t endTime = 0;
+  uint8_t inputOpen = 1;
+  while ((inputOpen) || ((int32_t) (mock_micros - endTime) < 0)) {
+    if ((inputOpen) && (!Serial.available())) {
+      uint8_t buf[256];
+      ssize_t len = read(STDIN_FILENO, buf, sizeof(buf));
+      if (len > 0) Serial.feed(buf, len);
+      else if ((len == 0) || (errno != EAGAIN)) {
+        inputOpen = 0;
+        endTime = mock_micros + RUN_AFTER_EOF;
+      }
+    }
+
+    loop();
+    mockInterrupts();
+    mock_micros += LOOP_STEP;
+
+    if (Serial.outLen) {
+      fwrite(Serial.out, 1, Serial.outLen, stdout);
+      fflush(stdout);
+      Serial.outLen = 0;
+    }
+    if (hidlen) {
+      fprintf(stderr, "%s\n", hidlog);
+      hidlen = 0;
+    }
+    if (inputOpen) usleep(LOOP_STEP);
+  }
+  return 0;
+}
@@ -0,0 +1,167 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: Arduino.h - host build: mock of the Arduino AVR core (ATmega32u4, Leonardo pin mapping)
+
+     The time is virtual (mock_micros), it only advances when the firmware or the test says so:
+     millis() and micros() add a few microseconds per call, analogRead() the conversion time.
+     Pins are set with mockSetPin(), the PINx registers follow them. Serial and Serial1 are
+     buffers: the test feeds input with feed() and reads the output from out[].
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#ifndef _MOCK_ARDUINO_H_
+#define _MOCK_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define DEC 10
+#define HEX 16
+#define A0 18
+#define A1 19
+#define A8 26
+#define A9 27
+#define A10 28
+#define LED_BUILTIN_RX 17
+#define LED_BUILTIN_TX 30
+#define TXLED1
+#define NOT_AN_INTERRUPT -1
+#define NOT_A_PORT 0
+
+#define MOCK_PINS 32
+
+extern uint32_t mock_micros;            // virtual time in microseconds
+extern int mock_pins[MOCK_PINS];        // level of the digital pins
+extern int mock_analog;                 // value of every analog input
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(unsigned int us);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void pinMode(uint8_t pin, uint8_t mode);
+int analogRead(uint8_t pin);
+void attachInterrupt(uint8_t interruptNum, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+
+void mockSetPin(uint8_t pin, int value);
+void mockPinChange(uint8_t pin, int value);
+void mockInterrupts();
+void mockAttachEEPROM(const char * fileName);
+extern void (*mock_irq[8])(void);       // handlers of attachInterrupt()
+
+// pin mapping of the Leonardo / Pro Micro core (pins_arduino.h)
+extern volatile uint8_t * const mock_port_input[7];
+uint8_t digitalPinToPort(uint8_t pin);
+uint8_t digitalPinToBitMask(uint8_t pin);
+#define portInputRegister(p) ((volatile uint8_t *) mock_port_input[p])
+#define digitalPinToInterrupt(p) ((p) == 0 ? 2 : ((p) == 1 ? 3 : ((p) == 2 ? 1 : ((p) == 3 ? 0 : ((p) == 7 ? 4 : NOT_AN_INTERRUPT)))))
+#define digitalPinToPCICR(p)    ((((p) >= 8 && (p) <= 11) || ((p) >= 14 && (p) <= 17) || ((p) >= A8 && (p) <= A10)) ? (&PCICR) : ((volatile uint8_t *) 0))
+#define digitalPinToPCICRbit(p) 0
+#define digitalPinToPCMSK(p)    ((((p) >= 8 && (p) <= 11) || ((p) >= 14 && (p) <= 17) || ((p) >= A8 && (p) <= A10)) ? (&PCMSK0) : ((volatile uint8_t *) 0))
+#define digitalPinToPCMSKbit(p) (((p) >= 8 && (p) <= 11) ? (p) - 4 : ((p) == 14 ? 3 : ((p) == 15 ? 1 : ((p) == 16 ? 2 : ((p) == 17 ? 0 : ((p) - A8 + 4))))))
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define PSTR(s) (s)
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t * buffer, size_t size) { size_t n = 0; while (size--) n += write(*buffer++); return n; }
+    size_t write(const char * str) { return write((const uint8_t *) str, strlen(str)); }
+    size_t write(const char * buffer, size_t size) { return write((const uint8_t *) buffer, size); }
+
+    size_t print(const __FlashStringHelper * str) { return write((const char *) str); }
+    size_t print(const char * str) { return write(str); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(unsigned char n, int base = DEC) { return printNumber(n, base); }
+    size_t print(int n, int base = DEC) { return print((long) n, base); }
+    size_t print(unsigned int n, int base = DEC) { return printNumber(n, base); }
+    size_t print(long n, int base = DEC) {
+      if ((n < 0) && (base == DEC)) return write('-') + printNumber(-(unsigned long) n, base);
+      return printNumber((unsigned long) n, base);
+    }
+    size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); }
+    size_t println() { return write("\r\n"); }
+    template<class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template<class T> size_t println(T value, int base) { size_t n = print(value, base); return n + println(); }
+
+  private:
+    size_t printNumber(unsigned long n, int base) {
+      char buf[8 * sizeof(long) + 1];
+      char * p = buf + sizeof(buf) - 1;
+      *p = 0;
+      do { int d = n % base; *--p = d < 10 ? '0' + d : 'A' + d - 10; n /= base; } while (n);
+      return write(p);
+    }
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    virtual void flush() {}
+};
+
+#define MOCK_SERIAL_IN_LEN   4096
+#define MOCK_SERIAL_OUT_LEN 65536
+
+class MockSerial : public Stream {
+  public:
+    char in[MOCK_SERIAL_IN_LEN];         // received bytes, see feed()
+    int inHead = 0, inTail = 0;
+    char out[MOCK_SERIAL_OUT_LEN];       // sent bytes (zero terminated), cleared by the test
+    int outLen = 0;
+    int txSpace = 1000000;               // free space of the USB endpoint (0: host does not read)
+
+    void begin(long) {}
+    void end() {}
+    int available() { return inTail - inHead; }
+    int read() { return inHead < inTail ? (uint8_t) in[inHead++] : -1; }
+    int peek() { return inHead < inTail ? (uint8_t) in[inHead] : -1; }
+    int availableForWrite() { return txSpace; }
+    size_t write(uint8_t c) { if (outLen < MOCK_SERIAL_OUT_LEN - 1) out[outLen++] = c; out[outLen] = 0; return 1; }
+    using Print::write;
+    size_t write(int n) { return write((uint8_t) n); }
+    size_t write(unsigned int n) { return write((uint8_t) n); }
+    size_t write(long n) { return write((uint8_t) n); }
+    operator bool() { return true; }
+
+    void feed(const uint8_t * data, int len) {
+      if (inHead == inTail) inHead = inTail = 0;
+      while ((len--) && (inTail < MOCK_SERIAL_IN_LEN)) in[inTail++] = *data++;
+    }
+    void feed(const char * str) { feed((const uint8_t *) str, strlen(str)); }
+};
+
+extern MockSerial Serial, Serial1;
+
+#endif
@@ -0,0 +1,32 @@
+// host build: internal EEPROM of the ATmega32u4, optionally stored in a file (see mockAttachEEPROM())
+
+#ifndef _MOCK_EEPROM_H_
+#define _MOCK_EEPROM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define MOCK_EEPROM_SIZE 1024
+
+struct MockEEPROM {
+  uint8_t mem[MOCK_EEPROM_SIZE];
+  unsigned long reads = 0, writes = 0;
+  unsigned long wear[MOCK_EEPROM_SIZE];   // writes per cell
+  long writeLimit = -1;                   // >= 0: number of writes which are still done (power loss simulation)
+  FILE * file = 0;                        // write-through copy, see mockAttachEEPROM()
+
+  MockEEPROM() { for (int i = 0; i < MOCK_EEPROM_SIZE; i++) { mem[i] = 0xff; wear[i] = 0; } }
+  uint8_t read(int address) { reads++; return mem[address]; }
+  void write(int address, uint8_t value) {
+    if (writeLimit == 0) return;
+    if (writeLimit > 0) writeLimit--;
+    writes++; wear[address]++; mem[address] = value;
+    if (file) { fseek(file, address, SEEK_SET); fputc(value, file); fflush(file); }
+  }
+  void update(int address, uint8_t value) { if (mem[address] != value) write(address, value); }
+  uint16_t length() { return MOCK_EEPROM_SIZE; }
+};
+
+extern MockEEPROM EEPROM;
+
+#endif
@@ -0,0 +1,23 @@
+// host build: USB mouse of the Arduino core, the reports are logged (see mock.cpp)
+
+#ifndef _MOCK_MOUSE_H_
+#define _MOCK_MOUSE_H_
+
+#include <stdint.h>
+
+#define MOUSE_LEFT 1
+#define MOUSE_RIGHT 2
+#define MOUSE_MIDDLE 4
+
+struct MockMouse {
+  uint8_t buttons = 0;
+  void begin() {}
+  void press(uint8_t b);
+  void release(uint8_t b);
+  bool isPressed(uint8_t b) { return buttons & b; }
+  void move(signed char x, signed char y, signed char wheel = 0);
+};
+
+extern MockMouse Mouse;
+
+#endif
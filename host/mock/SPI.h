@@ -0,0 +1 @@
+// host build: the SPI library is not used by the firmware
@@ -0,0 +1,19 @@
+// host build: WS2812 (NeoPixel) library, without output
+
+#ifndef _MOCK_WS2812_H_
+#define _MOCK_WS2812_H_
+
+#include <stdint.h>
+
+struct cRGB { uint8_t g, r, b; };
+
+class WS2812 {
+  public:
+    WS2812(uint16_t) {}
+    void setOutput(uint8_t) {}
+    void setColorOrderGRB() {}
+    uint8_t set_crgb_at(uint16_t, cRGB) { return 0; }
+    void sync() {}
+};
+
+#endif
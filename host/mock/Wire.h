@@ -0,0 +1,97 @@
+// host build: Wire (I2C) library with an emulated 24LCxx EEPROM at address 0x50 (see storageBackend.cpp)
+
+#ifndef _MOCK_WIRE_H_
+#define _MOCK_WIRE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+extern uint32_t mock_micros;
+
+#define MOCK_WIRE_BUFFER_LEN 32        // buffer size of the Wire library
+#define MOCK_I2C_BIT_TIME_NS 2500      // 400 kHz
+#define MOCK_I2C_WRITE_TIME  5000      // page write cycle in microseconds, the chip does not acknowledge meanwhile
+
+/**
+   a 24LCxx EEPROM: a write transfer stores its bytes within one page (the address wraps
+   at the page boundary), every transfer advances the virtual time by its bus time
+*/
+struct MockI2CEeprom {
+  uint8_t mem[65536];
+  uint32_t size = 32768;               // set size, page and addrBytes for the emulated chip
+  uint32_t page = 64;
+  int addrBytes = 2;
+  uint32_t busyUntil = 0;              // end of the current write cycle
+  uint32_t pointer = 0;                // address of the next read
+  unsigned long pageWrites = 0, bytesWritten = 0, transfers = 0, nacks = 0;
+  unsigned long wear[65536];
+  long writeLimit = -1;                // >= 0: number of page writes which are still done (power loss simulation)
+  MockI2CEeprom() { memset(mem, 0xff, sizeof(mem)); memset(wear, 0, sizeof(wear)); }
+};
+
+extern MockI2CEeprom I2CEEPROM;
+
+class TwoWire {
+  public:
+    void begin() {}
+    void setClock(uint32_t) {}
+    void beginTransmission(uint8_t address) { device = address; txLen = 0; }
+    size_t write(uint8_t b) { if (txLen >= MOCK_WIRE_BUFFER_LEN) return 0; txBuffer[txLen++] = b; return 1; }
+    size_t write(const uint8_t * data, size_t len) { size_t n = 0; while ((len--) && (write(*data++))) n++; return n; }
+
+    uint8_t endTransmission(bool stop = true) {
+      MockI2CEeprom & e = I2CEEPROM;
+      e.transfers++;
+      busTime(txLen + 1);
+      if ((device & 0x78) != 0x50) return 2;                      // no device: address not acknowledged
+      if ((int32_t) (mock_micros - e.busyUntil) < 0) { e.nacks++; return 2; }
+      if (txLen < e.addrBytes) return 0;
+      uint32_t address = (e.addrBytes == 2) ? ((txBuffer[0] << 8) | txBuffer[1]) : (((device & 7) << 8) | txBuffer[0]);
+      address %= e.size;
+      e.pointer = address;
+      int n = txLen - e.addrBytes;
+      if (n > 0) {
+        if (e.writeLimit == 0) return 0;
+        if (e.writeLimit > 0) e.writeLimit--;
+        uint32_t base = address - address % e.page;
+        for (int i = 0; i < n; i++) {
+          uint32_t a = base + (address - base + i) % e.page;
+          e.mem[a] = txBuffer[e.addrBytes + i];
+          e.wear[a]++;
+        }
+        e.pageWrites++;
+        e.bytesWritten += n;
+        e.busyUntil = mock_micros + MOCK_I2C_WRITE_TIME;
+      }
+      return 0;
+    }
+
+    uint8_t requestFrom(uint8_t address, uint8_t len) {
+      MockI2CEeprom & e = I2CEEPROM;
+      e.transfers++;
+      busTime(len + 1);
+      rxLen = rxPos = 0;
+      if ((int32_t) (mock_micros - e.busyUntil) < 0) { e.nacks++; return 0; }
+      for (int i = 0; (i < len) && (i < MOCK_WIRE_BUFFER_LEN); i++) {
+        rxBuffer[i] = e.mem[e.pointer];
+        e.pointer = (e.pointer + 1) % e.size;
+        rxLen++;
+      }
+      return rxLen;
+    }
+    int available() { return rxLen - rxPos; }
+    int read() { return rxPos < rxLen ? rxBuffer[rxPos++] : -1; }
+
+  private:
+    void busTime(int bytes) { mock_micros += bytes * 9 * MOCK_I2C_BIT_TIME_NS / 1000; }
+    uint8_t device = 0;
+    uint8_t txBuffer[MOCK_WIRE_BUFFER_LEN];
+    int txLen = 0;
+    uint8_t rxBuffer[MOCK_WIRE_BUFFER_LEN];
+    int rxLen = 0, rxPos = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,18 @@
+// host build: interrupt vectors are plain functions, the mock calls them (see mockInterrupts(), mockPinChange())
+// while interrupts are disabled (cli / noInterrupts); sei runs an EEPROM ready interrupt which became due meanwhile
+
+#ifndef _MOCK_AVR_INTERRUPT_H_
+#define _MOCK_AVR_INTERRUPT_H_
+
+#define ISR(vector, ...) extern "C" void vector(void); void vector(void)
+#include <stdint.h>
+
+extern uint8_t mock_interruptsEnabled;
+void mockSei();
+
+#define cli()           (mock_interruptsEnabled = 0)
+#define sei()           mockSei()
+#define noInterrupts()  cli()
+#define interrupts()    sei()
+
+#endif
@@ -0,0 +1,59 @@
+// host build: the ATmega32u4 registers which the firmware uses
+
+#ifndef _MOCK_AVR_IO_H_
+#define _MOCK_AVR_IO_H_
+
+#include <stdint.h>
+
+extern volatile uint8_t PORTB, PORTC, PORTD, PORTE, PORTF, PINB, PINC, PIND, PINE, PINF, DDRD;
+extern volatile uint8_t PCICR, PCMSK0, PCIFR, EIMSK, EIFR, TIMSK3, TCCR3A, TCCR3B;
+extern volatile uint8_t ADMUX, ADCSRA, ADCSRB, DIDR0, DIDR2, EEDR, SREG;
+extern volatile uint16_t OCR3A, OCR3B, ADC, EEAR;
+
+/**
+   EEPROM control register: setting EEPE writes EEDR to address EEAR, EEPE stays set for the
+   write time (3.4 ms of the mock clock). Reading EEPE while it is set takes 1 microsecond, so that
+   a busy wait advances the clock; the EEPROM ready interrupt runs during the wait if interrupts are enabled.
+   A write is counted as started by the main loop or by EE_READY_vect (eeSyncWrites / eeIsrWrites)
+*/
+struct MockEECR {
+  uint8_t value = 0;
+  void operator|=(uint8_t mask);
+  void operator&=(uint8_t mask) { value &= mask; }
+  uint8_t operator&(uint8_t mask);
+};
+extern MockEECR EECR;
+extern unsigned long eeSyncWrites, eeIsrWrites;
+
+#define PD4 4
+#define WGM30 0
+#define WGM31 1
+#define WGM32 3
+#define WGM33 4
+#define CS30 0
+#define CS31 1
+#define OCIE3A 1
+#define OCIE3B 2
+#define PCIE0 0
+#define REFS0 6
+#define MUX0 0
+#define MUX1 1
+#define MUX2 2
+#define MUX5 5
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+#define ADC7D 7
+#define EERIE 3
+#define EEMPE 2
+#define EEPE 1
+#define EERE 0
+#define _BV(b) (1 << (b))
+#define E2END 1023
+
+#endif
@@ -0,0 +1,30 @@
+// host build: program memory is ordinary memory
+
+#ifndef _MOCK_AVR_PGMSPACE_H_
+#define _MOCK_AVR_PGMSPACE_H_
+
+#include <string.h>
+#include <stdint.h>
+
+#define PROGMEM
+typedef uintptr_t uint_farptr_t;
+
+static inline uint16_t mockReadWord(const void * a) { uint16_t v; memcpy(&v, a, sizeof(v)); return v; }
+static inline uint32_t mockReadDword(const void * a) { uint32_t v; memcpy(&v, a, sizeof(v)); return v; }
+static inline void * mockReadPtr(const void * a) { void * v; memcpy(&v, a, sizeof(v)); return v; }
+
+#define pgm_read_byte(a)        (*(const uint8_t *) (a))
+#define pgm_read_byte_near(a)   (*(const uint8_t *) (a))
+#define pgm_read_word(a)        mockReadWord(a)
+#define pgm_read_word_near(a)   mockReadWord(a)
+#define pgm_read_dword(a)       mockReadDword(a)
+#define pgm_read_ptr(a)         mockReadPtr(a)
+#define memcpy_P                memcpy
+#define strcmp_P(a, b)          strcmp((a), (b))
+#define strncmp_P(a, b, n)      strncmp((a), (b), (n))
+#define strlen_P                strlen
+#define strcpy_P                strcpy
+#define strcpy_PF(d, s)         strcpy((d), (const char *) (uintptr_t) (s))
+#define strcmp_PF(d, s)         strcmp((d), (const char *) (uintptr_t) (s))
+
+#endif
@@ -0,0 +1,205 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: mock.cpp - host build: globals of the mock Arduino core, virtual clock, pins, HID log
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "Mouse.h"
+#include "Keyboard.h"
+#include "Wire.h"
+
+uint32_t mock_micros = 0;
+int mock_pins[MOCK_PINS];
+int mock_analog = 512;
+
+volatile uint8_t PORTB, PORTC, PORTD, PORTE, PORTF, PINB, PINC, PIND, PINE, PINF, DDRD;
+volatile uint8_t PCICR, PCMSK0, PCIFR, EIMSK, EIFR, TIMSK3, TCCR3A, TCCR3B;
+volatile uint8_t ADMUX, ADCSRA, ADCSRB, DIDR0, DIDR2, EEDR, SREG;
+volatile uint16_t OCR3A, OCR3B, ADC, EEAR;
+volatile uint8_t * const mock_port_input[7] = { 0, 0, &PINB, &PINC, &PIND, &PINE, &PINF };
+
+MockSerial Serial, Serial1;
+MockEEPROM EEPROM;
+MockEECR EECR;
+MockMouse Mouse;
+MockKeyboard Keyboard;
+TwoWire Wire;
+MockI2CEeprom I2CEEPROM;
+
+// fonts and keyboard layout of the libraries (not used on the host)
+extern const uint8_t ssd1306xled_font8x16[1]; const uint8_t ssd1306xled_font8x16[1] = { 0 };
+extern const uint8_t ssd1306xled_font6x8[1]; const uint8_t ssd1306xled_font6x8[1] = { 0 };
+extern const uint8_t _asciimap[128]; const uint8_t _asciimap[128] = { 0 };
+
+int __heap_start, * __brkval;    // for freeRam()
+
+char hidlog[65536];              // HID reports since the last clearOut(), e.g. "[KP 4][KR 4]"
+int hidlen = 0;
+
+unsigned long eeSyncWrites = 0, eeIsrWrites = 0;
+static uint8_t inEepromInterrupt = 0;
+static uint32_t eepromReadyTime = 0;
+
+#define EEPROM_WRITE_TIME  3400   // duration of an EEPROM write in microseconds
+
+static void logHid(const char * format, int a, int b = 0, int c = 0)
+{
+  hidlen += snprintf(hidlog + hidlen, sizeof(hidlog) - hidlen, format, a, b, c);
+  if (hidlen >= (int) sizeof(hidlog)) hidlen = sizeof(hidlog) - 1;
+}
+
+void MockMouse::press(uint8_t b) { buttons |= b; logHid("[MP %d]", b); }
+void MockMouse::release(uint8_t b) { buttons &= ~b; logHid("[MR %d]", b); }
+void MockMouse::move(signed char x, signed char y, signed char wheel) { logHid("[MM %d %d %d]", x, y, wheel); }
+size_t MockKeyboard::press(uint8_t k) { logHid("[KP %d]", k); return 1; }
+size_t MockKeyboard::release(uint8_t k) { logHid("[KR %d]", k); return 1; }
+void MockKeyboard::releaseAll() { logHid("[KRA]", 0); }
+
+static void mockEepromReady();
+
+void MockEECR::operator|=(uint8_t mask)
+{
+  if (mask & (1 << EEPE)) {
+    EEPROM.write(EEAR, EEDR);
+    if (inEepromInterrupt) eeIsrWrites++;
+    else eeSyncWrites++;
+    eepromReadyTime = mock_micros + EEPROM_WRITE_TIME;
+  }
+  value |= mask;
+}
+
+uint8_t MockEECR::operator&(uint8_t mask)
+{
+  mockEepromReady();               // an interrupt which became due runs first
+  if ((value & (1 << EEPE)) && ((int32_t) (mock_micros - eepromReadyTime) >= 0)) value &= ~(1 << EEPE);
+  if ((mask & (1 << EEPE)) && (value & (1 << EEPE))) mock_micros++;     // busy wait for the end of the write
+  return value & mask;
+}
+
+uint32_t millis() { mock_micros += 2; return mock_micros / 1000; }
+uint32_t micros() { mock_micros += 1; return mock_micros; }
+void delay(uint32_t ms) { mock_micros += ms * 1000; }
+void delayMicroseconds(unsigned int us) { mock_micros += us; }
+
+// Leonardo pin mapping: port (index of mock_port_input[]) and bit of the digital pins
+static const uint8_t pinPort[MOCK_PINS] = { 4, 4, 4, 4, 4, 3, 4, 5, 2, 2, 2, 2, 4, 3, 2, 2, 2, 2, 6, 6, 6, 6, 6, 6, 4, 4, 2, 2, 2, 4, 4, 0 };
+static const uint8_t pinBit[MOCK_PINS]  = { 2, 3, 1, 0, 4, 6, 7, 6, 4, 5, 6, 7, 6, 7, 3, 1, 2, 0, 7, 6, 5, 4, 1, 0, 4, 7, 4, 5, 6, 5, 5, 0 };
+
+uint8_t digitalPinToPort(uint8_t pin) { return pinPort[pin]; }
+uint8_t digitalPinToBitMask(uint8_t pin) { return 1 << pinBit[pin]; }
+
+void mockSetPin(uint8_t pin, int value)
+{
+  mock_pins[pin] = value;
+  volatile uint8_t * reg = mock_port_input[pinPort[pin]];
+  if (reg) {
+    if (value) *reg |= 1 << pinBit[pin];
+    else *reg &= ~(1 << pinBit[pin]);
+  }
+}
+
+int digitalRead(uint8_t pin) { return mock_pins[pin]; }
+void digitalWrite(uint8_t, uint8_t) {}
+void pinMode(uint8_t pin, uint8_t mode) { if (mode == INPUT_PULLUP) mockSetPin(pin, 1); }
+int analogRead(uint8_t) { mock_micros += 110; return mock_analog; }
+
+uint8_t mock_interruptsEnabled = 1;
+void (*mock_irq[8])(void);
+
+// EIMSK bit of an interrupt number of attachInterrupt() (the fifth external interrupt is INT6)
+static uint8_t eimskBit(uint8_t interruptNum) { return 1 << (interruptNum == 4 ? 6 : interruptNum); }
+
+void attachInterrupt(uint8_t interruptNum, void (*handler)(void), int)
+{
+  mock_irq[interruptNum] = handler;
+  EIMSK |= eimskBit(interruptNum);
+}
+
+void detachInterrupt(uint8_t interruptNum)
+{
+  EIMSK &= ~eimskBit(interruptNum);
+  mock_irq[interruptNum] = 0;
+}
+
+extern "C" void ADC_vect(void);
+extern "C" void EE_READY_vect(void) __attribute__((weak));
+extern "C" void PCINT0_vect(void) __attribute__((weak));
+
+/**
+   changes the level of a pin and runs the interrupt of the pin if it is enabled:
+   INTn (attachInterrupt, EIMSK) or PCINT0 (PORTB pins, PCICR and PCMSK0);
+   an edge while interrupts are disabled is lost
+*/
+void mockPinChange(uint8_t pin, int value)
+{
+  mockSetPin(pin, value);
+  if (!mock_interruptsEnabled) return;
+  int interruptNum = digitalPinToInterrupt(pin);
+  if (interruptNum != NOT_AN_INTERRUPT) {
+    if ((EIMSK & eimskBit(interruptNum)) && (mock_irq[interruptNum])) mock_irq[interruptNum]();
+  }
+  else if ((pinPort[pin] == 2) && (PCINT0_vect) && (PCICR & (1 << PCIE0)) && (PCMSK0 & (1 << pinBit[pin])))
+    PCINT0_vect();
+}
+
+/**
+   runs the interrupts which are due (unless interrupts are disabled): the ADC conversions since the last call
+   (free running at ~9.6 kHz, 16 per call are enough for a 100 us step) and EE_READY
+   when the last EEPROM write is complete
+*/
+void mockInterrupts()
+{
+  if (!mock_interruptsEnabled) return;
+  if (ADCSRA & (1 << ADIE))
+    for (int i = 0; i < 16; i++) { ADC = mock_analog; ADC_vect(); }
+  mockEepromReady();
+}
+
+/**
+   runs EE_READY (with interrupts disabled, like an ISR) if it is enabled and the last EEPROM write is complete
+*/
+static void mockEepromReady()
+{
+  if ((!mock_interruptsEnabled) || (inEepromInterrupt) || (!EE_READY_vect) || (!(EECR.value & (1 << EERIE))) ||
+      ((int32_t) (mock_micros - eepromReadyTime) < 0)) return;
+  EECR.value &= ~(1 << EEPE);
+  inEepromInterrupt = 1;
+  mock_interruptsEnabled = 0;
+  EE_READY_vect();
+  mock_interruptsEnabled = 1;
+  inEepromInterrupt = 0;
+}
+
+void mockSei()
+{
+  mock_interruptsEnabled = 1;
+  mockEepromReady();
+}
+
+/**
+   stores the EEPROM in a file: the content is loaded from the file (if it exists)
+   and every write goes to the file
+*/
+void mockAttachEEPROM(const char * fileName)
+{
+  FILE * f = fopen(fileName, "r+b");
+  if (f) {
+    if (fread(EEPROM.mem, 1, MOCK_EEPROM_SIZE, f) != MOCK_EEPROM_SIZE) fprintf(stderr, "%s: short EEPROM file\n", fileName);
+  }
+  else {
+    f = fopen(fileName, "w+b");
+    if (!f) { perror(fileName); return; }
+    fwrite(EEPROM.mem, 1, MOCK_EEPROM_SIZE, f);
+    fflush(f);
+  }
+  EEPROM.file = f;
+}
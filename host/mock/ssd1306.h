@@ -0,0 +1,19 @@
+// host build: ssd1306 display library, without output
+
+#ifndef _MOCK_SSD1306_H_
+#define _MOCK_SSD1306_H_
+
+#include <stdint.h>
+
+#define STYLE_NORMAL 0
+
+extern const uint8_t ssd1306xled_font8x16[];
+extern const uint8_t ssd1306xled_font6x8[];
+
+static inline void ssd1306_setFixedFont(const uint8_t *) {}
+static inline void ssd1306_128x32_i2c_init() {}
+static inline void ssd1306_clearScreen() {}
+static inline void ssd1306_drawXBitmap(int, int, int, int, const uint8_t *) {}
+static inline void ssd1306_printFixed(int, int, const char *, int) {}
+
+#endif
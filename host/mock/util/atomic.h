@@ -0,0 +1,12 @@
+// host build: the block runs with interrupts disabled, see avr/interrupt.h
+
+#ifndef _MOCK_UTIL_ATOMIC_H_
+#define _MOCK_UTIL_ATOMIC_H_
+
+#include <avr/interrupt.h>
+
+#define ATOMIC_BLOCK(type) for (uint8_t _atomicState = mock_interruptsEnabled, _atomicOnce = (cli(), 1); \
+                                _atomicOnce; _atomicState ? sei() : (void) cli(), _atomicOnce = 0)
+#define ATOMIC_RESTORESTATE
+
+#endif
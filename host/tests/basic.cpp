@@ -0,0 +1,33 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: basic.cpp - test: AT commands, saving a slot, HID reports of a button
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+int main()
+{
+  pinsHigh();
+  setup();
+  clearOut();
+  cmd("AT ID");
+  cmd("AT LA");
+  cmd("AT BM 1");
+  cmd("AT KP KEY_A KEY_B");
+  cmd("AT SA test");
+  runFor(300);                      // the slot is written in the background
+  cmd("AT LI");
+  printOut();
+  clearOut();
+  pressPin(2);
+  printf("\nHID: %s\n", hidlog);
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: binary_protocol.cpp - test: binary configuration frames (binaryProtocol.cpp)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include "binaryProtocol.h"
+#include <util/crc16.h>
+
+/**
+   sends a frame: start byte, length, opcode, payload, CRC (corrupt 1: wrong CRC, 2: wrong start byte)
+*/
+static void sendHostFrame(uint8_t opcode, const void * payload, uint8_t len, int corrupt = 0)
+{
+  uint8_t frame[FRAME_MAX_PAYLOAD + 5];
+  int n = 0;
+  uint16_t crc = 0xffff;
+  frame[n++] = (corrupt == 2) ? FRAME_MAGIC ^ 0x10 : FRAME_MAGIC;
+  frame[n++] = len;
+  frame[n++] = opcode;
+  crc = _crc_ccitt_update(crc, len);
+  crc = _crc_ccitt_update(crc, opcode);
+  for (int i = 0; i < len; i++) {
+    frame[n++] = ((const uint8_t *) payload)[i];
+    crc = _crc_ccitt_update(crc, ((const uint8_t *) payload)[i]);
+  }
+  if (corrupt == 1) crc ^= 1;
+  frame[n++] = crc & 0xff;
+  frame[n++] = crc >> 8;
+  Serial.feed(frame, n);
+}
+
+/**
+   sends FRAME_SAVE_SLOT: the number of frames sent since the last save, the slot name
+*/
+static void sendSaveSlot(uint8_t count, const char * slotname)
+{
+  uint8_t payload[MAX_SLOTNAME_LEN];
+  payload[0] = count;
+  memcpy(payload + 1, slotname, strlen(slotname));
+  sendHostFrame(FRAME_SAVE_SLOT, payload, strlen(slotname) + 1);
+}
+
+/**
+   bitwise CRC-16/MCRF4XX: reflected polynomial 0x8408, no final xor (reference for _crc_ccitt_update())
+*/
+static uint16_t crcMCRF4XX(uint16_t crc, uint8_t data)
+{
+  crc ^= data;
+  for (int i = 0; i < 8; i++) crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : (crc >> 1);
+  return crc;
+}
+
+/**
+   prints the output, bytes which are not printable as <hex>
+*/
+static void printFrames()
+{
+  for (int i = 0; i < Serial.outLen; i++) {
+    uint8_t c = Serial.out[i];
+    if ((c >= 32) && (c < 127)) putchar(c);
+    else printf("<%02X>", c);
+  }
+  printf("\n");
+  clearOut();
+}
+
+int main()
+{
+  const uint8_t button1[] = { 2, 'K', 'P', 0, 0, 'K', 'E', 'Y', '_', 'B' };
+  const uint8_t setTS[] = { 'T', 'S', 44, 1, 0, 0 };
+  const uint8_t unknown[] = { 'X', 'X', 1, 0, 0, 0 };
+
+  // the frame crc: check value of "123456789", and every data byte with crc values across the 16 bit range
+  uint16_t crc = 0xffff, reference = 0xffff;
+  for (const char * c = "123456789"; *c; c++) {
+    crc = _crc_ccitt_update(crc, *c);
+    reference = crcMCRF4XX(reference, *c);
+  }
+  int mismatches = 0;
+  for (uint32_t i = 0; i < 0x10000; i += 0xff)
+    for (int b = 0; b < 256; b++)
+      if (_crc_ccitt_update(i, b) != crcMCRF4XX(i, b)) mismatches++;
+  printf("crc check value %04X, reference %04X, mismatches %d\n", crc, reference, mismatches);
+
+  pinsHigh();
+  setup();
+  clearOut();
+
+  // a rejected setting: the following save is rejected too
+  sendHostFrame(FRAME_SET_BUTTON, button1, sizeof(button1));
+  sendHostFrame(FRAME_SET_SETTING, setTS, sizeof(setTS));
+  sendHostFrame(FRAME_SET_SETTING, unknown, sizeof(unknown));
+  sendSaveSlot(3, "binslot");
+  runFor(10);
+  printFrames();
+
+  // CRC error: the transaction is rejected
+  sendHostFrame(FRAME_SET_SETTING, setTS, sizeof(setTS));
+  sendHostFrame(FRAME_SET_SETTING, setTS, sizeof(setTS), 1);
+  sendSaveSlot(2, "binslot");
+  runFor(10);
+  printFrames();
+
+  // corrupted start byte: the frame is lost without a reply, the frame count of the save differs
+  sendHostFrame(FRAME_SET_SETTING, setTS, sizeof(setTS));
+  sendHostFrame(FRAME_SET_BUTTON, button1, sizeof(button1), 2);
+  sendSaveSlot(2, "binslot");
+  runFor(10);
+  printFrames();
+  cmd("AT");                        // the bytes of the lost frame went to the AT command parser
+  clearOut();
+
+  sendHostFrame(FRAME_SET_BUTTON, button1, sizeof(button1));
+  sendSaveSlot(1, "binslot");
+  runFor(10);
+  printFrames();
+  cmd("AT LI");
+  printFrames();
+
+  sendHostFrame(FRAME_READ_SLOT, "binslot", 7);
+  runFor(10);
+  printFrames();
+  printf("ts=%u mode=%d ks=%s\n", settings.ts, buttons[1].mode, getKeystring(1));
+  cmd("AT ID");
+  printFrames();
+
+  // a keystring which does not fit into a frame: only the NAK (FRAME_ERR_LENGTH) is sent
+  char longKeystring[FRAME_MAX_PAYLOAD];
+  memset(longKeystring, 'x', sizeof(longKeystring) - 1);
+  longKeystring[sizeof(longKeystring) - 1] = 0;
+  setKeystring(1, longKeystring);
+  printf("keystring length %u\n", (unsigned) strlen(getKeystring(1)));
+  sendHostFrame(FRAME_READ_SLOT, "", 0);
+  runFor(10);
+  printFrames();
+  return 0;
+}
@@ -0,0 +1,27 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: command_hash.cpp - test: every AT command is found by the perfect hash, no other letter pair is
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+
+int main()
+{
+  int wrong = 0, found = 0;
+  for (int i = 0; i < NUM_COMMANDS; i++)
+    if (lookupCommand(atCommands[i].atCmd[0], atCommands[i].atCmd[1]) != i) wrong++;
+  for (char a = 'A'; a <= 'Z'; a++)
+    for (char b = 'A'; b <= 'Z'; b++)
+      if (lookupCommand(a, b) >= 0) found++;
+  printf("wrong=%d found=%d of %d\n", wrong, found, NUM_COMMANDS);
+  return 0;
+}
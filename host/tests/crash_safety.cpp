@@ -0,0 +1,152 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: crash_safety.cpp - test: slot log wear leveling and power loss during a save (internal EEPROM)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include "eepromStorage.h"
+#include <string.h>
+
+extern uint8_t numSlots;
+
+static uint8_t snapshot[MOCK_EEPROM_SIZE];
+
+static uint8_t save(const char * name)
+{
+  uint8_t result = saveToEEPROM(name);
+  flushEEPROM();
+  return result;
+}
+
+static void editSlotOne(const char * text)
+{
+  char line[40];
+  cmd("AT LO one");
+  cmd("AT BM 1");
+  snprintf(line, sizeof(line), "AT KW %s", text);
+  cmd(line);
+}
+
+/**
+   checks the slots after a reboot: returns 1 if slot "one" holds newText, 2 if it holds
+   the old text, 0 if the slot list or slot "two" is broken
+*/
+static int checkSlots(const char * newText)
+{
+  clearOut();
+  cmd("AT LI");
+  if (strcmp(Serial.out, "Slot1:default\r\nSlot2:one\r\nSlot3:two\r\nOK\r\n")) {
+    printf("list: %s (numSlots=%d)\n", Serial.out, numSlots);
+    return 0;
+  }
+  cmd("AT LO two");
+  if (strcmp(getKeystring(0), "slot two text")) {
+    printf("slot two: [%s]\n", getKeystring(0));
+    return 0;
+  }
+  cmd("AT LO one");
+  if (!strcmp(getKeystring(0), newText)) return 1;
+  if (!strcmp(getKeystring(0), "old")) return 2;
+  return 0;
+}
+
+int main()
+{
+  pinsHigh();
+  setup();
+  runFor(20);
+  cmd("AT BM 1"); cmd("AT KW old"); cmd("AT SA one");
+  cmd("AT BM 1"); cmd("AT KW slot two text"); cmd("AT SA two");
+  printOut();
+  printf("slots=%d\n", numSlots);
+
+  // bytes written by an edit of the first slot
+  for (int i = 0; i < 3; i++) {
+    editSlotOne(i & 1 ? "old" : "a longer text");
+    flushEEPROM();
+    unsigned long writes = EEPROM.writes;
+    int result = save("one");
+    printf("edit save r=%d writes=%lu\n", result, EEPROM.writes - writes);
+  }
+
+  // wear leveling
+  memset(EEPROM.wear, 0, sizeof(EEPROM.wear));
+  unsigned long writes = EEPROM.writes;
+  for (int i = 0; i < 2000; i++) {
+    char text[20];
+    snprintf(text, sizeof(text), "t%d", i);
+    editSlotOne(text);
+    save("one");
+    clearOut();
+  }
+  unsigned long minWear = ~0UL, maxWear = 0;
+  for (unsigned i = 0; i < LOG_SIZE; i++) {
+    if (EEPROM.wear[i] < minWear) minWear = EEPROM.wear[i];
+    if (EEPROM.wear[i] > maxWear) maxWear = EEPROM.wear[i];
+  }
+  printf("2000 saves: writes=%lu (%.1f per save), wear min=%lu max=%lu\n",
+         EEPROM.writes - writes, (EEPROM.writes - writes) / 2000.0, minWear, maxWear);
+
+  editSlotOne("old");
+  save("one");
+  setup();
+  runFor(20);
+  printf("reboot check=%d\n", checkSlots("old"));
+
+  // power loss: a save is interrupted after k bytes, then the firmware reboots.
+  // afterwards, slot "one" must hold the old or the new text and slot "two" must be intact.
+  const char * newText = "new text for one";
+  memcpy(snapshot, EEPROM.mem, MOCK_EEPROM_SIZE);
+  writes = EEPROM.writes;
+  editSlotOne(newText);
+  save("one");
+  unsigned long saveWrites = EEPROM.writes - writes;
+  int olds = 0, news = 0, bad = 0;
+  for (int round = 0; round < 40; round++) {
+    for (unsigned long k = 0; k <= saveWrites + 2; k++) {
+      flushEEPROM();
+      memcpy(EEPROM.mem, snapshot, MOCK_EEPROM_SIZE);
+      setup();
+      runFor(5);
+      clearOut();
+      editSlotOne(newText);
+      EEPROM.writeLimit = k;
+      save("one");
+      EEPROM.writeLimit = -1;
+      setup();
+      runFor(5);
+      int result = checkSlots(newText);
+      if (result == 1) news++;
+      else if (result == 2) olds++;
+      else {
+        bad++;
+        printf("bad k=%lu round=%d\n", k, round);
+      }
+    }
+    // advance the log, so that the next round is interrupted at other addresses (and during compaction)
+    flushEEPROM();
+    memcpy(EEPROM.mem, snapshot, MOCK_EEPROM_SIZE);
+    setup();
+    runFor(5);
+    cmd("AT LO two");
+    save("two");
+    editSlotOne("old");
+    save("one");
+    memcpy(snapshot, EEPROM.mem, MOCK_EEPROM_SIZE);
+    writes = EEPROM.writes;
+    editSlotOne(newText);
+    save("one");
+    saveWrites = EEPROM.writes - writes;
+  }
+  printf("crash tests: old=%d new=%d bad=%d\n", olds, news, bad);
+  return 0;
+}
@@ -0,0 +1,64 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: edge_capture.cpp - test: switch edges captured by the pin interrupts, debouncing, reconfiguration (AT RS)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+extern uint16_t interruptButtons;
+
+/**
+   presses a switch with a bouncing edge (count level changes before it settles at pressed), 
+   prints the HID reports right after the edge and after the release
+*/
+static void bouncePress(const char * label, uint8_t pin, int bounces)
+{
+  clearOut();
+  runFor(2);
+  for (int i = 0; i < bounces; i++) mockPinChange(pin, i & 1);
+  mockPinChange(pin, 0);
+  uint32_t start = mock_micros;
+  loop();
+  printf("%s: after the edge (+%u us): %s\n", label, (unsigned) (mock_micros - start), hidlog);
+  runFor(50);
+  mockPinChange(pin, 1);
+  runFor(50);
+  printf("%s: after the release: %s\n", label, hidlog);
+}
+
+static void printMasks(const char * label)
+{
+  printf("%s: EIMSK=%02x PCICR=%02x PCMSK0=%02x interruptButtons=%03x interrupts %s\n", label, EIMSK, PCICR, PCMSK0,
+         interruptButtons, mock_interruptsEnabled ? "enabled" : "disabled");
+}
+
+int main()
+{
+  pinsHigh();
+  setup();
+  clearOut();
+  printMasks("setup");
+  cmd("AT AP 1");
+  cmd("AT BM 1"); cmd("AT KH KEY_A");
+  cmd("AT BM 7"); cmd("AT KH KEY_B");
+
+  bouncePress("INT1 (pin 2, button 1)", 2, 0);
+  bouncePress("PCINT4 (pin 8, button 7), 10 bounces", 8, 10);
+
+  // AT RS sets up the pins and interrupts again
+  PCMSK0 |= 0x80;         // a stale mask bit of an unused pin
+  cmd("AT RS");
+  printMasks("after AT RS");
+  cmd("AT AP 1");
+  cmd("AT BM 1"); cmd("AT KH KEY_A");
+  bouncePress("INT1 after AT RS", 2, 4);
+  return 0;
+}
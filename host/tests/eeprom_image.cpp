@@ -0,0 +1,112 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: eeprom_image.cpp - test: EEPROM image export (AT ED) and restore (AT EI / EW / EC)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include <string.h>
+
+static char image[8192];
+
+/**
+   sends the "AT E.." lines of an image (the output of AT ED) to the firmware
+*/
+static void restoreImage(char * img)
+{
+  char * line = strtok(img, "\r\n");
+  while (line) {
+    if (!strncmp(line, "AT E", 4)) {
+      Serial.feed(line);
+      Serial.feed("\r");
+      runFor(2);
+    }
+    line = strtok(0, "\r\n");
+  }
+  runFor(10);
+}
+
+int main()
+{
+  pinsHigh();
+  setup();
+  clearOut();
+  cmd("AT BM 2");
+  cmd("AT KW hello world");
+  cmd("AT SA one");
+  cmd("AT TS 300");
+  cmd("AT SA two");
+  runFor(300);                      // the slots are written in the background
+  clearOut();
+
+  cmd("AT ED");
+  strcpy(image, Serial.out);
+  printOut();
+  cmd("AT DE");
+  cmd("AT LI");
+  printOut();
+
+  restoreImage(image);
+  printOut();
+  cmd("AT LI");
+  cmd("AT LO two");
+  printOut();
+  printf("ts=%d ks=%s\n", settings.ts, getKeystring(1));
+
+  // corrupted image: one hex digit of the first data line is changed, the restore is rejected,
+  // the slots are kept
+  cmd("AT ED");
+  strcpy(image, Serial.out);
+  clearOut();
+  char * p = strstr(image, "AT EW ") + 8;
+  *p = (*p == '0') ? '1' : '0';
+  restoreImage(image);
+  printOut();
+  cmd("AT LI");
+  printOut();
+
+  // slots which use more than half of the EEPROM: the image does not fit next to them, 
+  // the log is erased by AT EI
+  for (int s = 0; s < 2; s++) {
+    for (int b = 1; b <= 4; b++) {
+      char line[80];
+      snprintf(line, sizeof(line), "AT BM %d", b);
+      cmd(line);
+      snprintf(line, sizeof(line), "AT KW slot %d button %d with a rather long keystring", s, b);
+      cmd(line);
+    }
+    cmd(s ? "AT SA big1" : "AT SA big0");
+  }
+  runFor(2000);
+  clearOut();
+  cmd("AT ED");
+  runFor(100);
+  strcpy(image, Serial.out);
+  clearOut();
+
+  // a corrupted image: only a default slot is left
+  char damaged[sizeof(image)];
+  strcpy(damaged, image);
+  p = strstr(damaged, "AT EW ") + 8;
+  *p = (*p == '0') ? '1' : '0';
+  restoreImage(damaged);
+  runFor(1000);
+  cmd("AT LI");
+  printOut();
+  clearOut();
+
+  // the intact image restores all slots
+  restoreImage(image);
+  runFor(1000);
+  cmd("AT LI");
+  printOut();
+  return 0;
+}
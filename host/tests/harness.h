@@ -0,0 +1,85 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: harness.h - host build: helpers for the tests and benchmarks
+
+     A test runs the firmware (setup(), loop()) on the virtual clock of the mock core:
+     runFor() calls loop() every 100 microseconds, cmd() sends an AT command and runs
+     the firmware for 10 ms. The output of the firmware is in Serial.out, the HID reports
+     are in hidlog. The tests print their results, "make check" compares them with
+     tests/<name>.expected.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#ifndef _HARNESS_H_
+#define _HARNESS_H_
+
+#include "Arduino.h"
+#include "EEPROM.h"
+
+#define LOOP_STEP 100         // time between two loop() calls in microseconds
+
+void setup();
+void loop();
+
+extern char hidlog[];
+extern int hidlen;
+
+static inline void pinsHigh()
+{
+  for (int i = 0; i < MOCK_PINS; i++) mockSetPin(i, 1);
+}
+
+static inline void runFor(uint32_t ms)
+{
+  uint32_t end = mock_micros + ms * 1000;
+  while ((int32_t) (mock_micros - end) < 0) {
+    loop();
+    mockInterrupts();
+    mock_micros += LOOP_STEP;
+  }
+}
+
+static inline void cmd(const char * str)
+{
+  Serial.feed(str);
+  Serial.feed("\r");
+  runFor(10);
+}
+
+/**
+   presses the switch at a pin for ms milliseconds, then releases it for ms milliseconds
+*/
+static inline void pressPin(uint8_t pin, uint32_t ms = 100)
+{
+  mockSetPin(pin, 0);
+  runFor(ms);
+  mockSetPin(pin, 1);
+  runFor(ms);
+}
+
+/**
+   prints the output of the firmware since the last clearOut() and clears it
+*/
+static inline void printOut()
+{
+  printf("%s", Serial.out);
+  Serial.outLen = 0;
+  Serial.out[0] = 0;
+}
+
+static inline void clearOut()
+{
+  Serial.outLen = 0;
+  Serial.out[0] = 0;
+  hidlen = 0;
+  hidlog[0] = 0;
+}
+
+#endif
@@ -0,0 +1,49 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: key_actions.cpp - test: HID reports of the keyboard commands (KW, KP, KH, KT, KR)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+int main()
+{
+  pinsHigh();
+  setup();
+  runFor(20);
+  clearOut();
+  cmd("AT BM 1"); cmd("AT KW Hi @x KEY_ENTER y KEY_FOO z");
+  cmd("AT BM 2"); cmd("AT KP KEY_CTRL  KEY_C ");
+  cmd("AT BM 3"); cmd("AT KH KEY_SHIFT KEY_UP");
+  cmd("AT BM 4"); cmd("AT KT KEY_A");
+  cmd("AT BM 5"); cmd("AT KR KEY_A");
+  for (int pin = 2; pin <= 6; pin++) {
+    clearOut();
+    pressPin(pin);
+    printf("btn%d: %s\n", pin - 1, hidlog);
+  }
+  clearOut();
+  pressPin(5);
+  printf("toggle again: %s\n", hidlog);
+
+  cmd("AT SA k");
+  cmd("AT LO k");
+  clearOut();
+  pressPin(3);
+  printf("after load btn2: %s\n", hidlog);
+
+  // a text which does not fit into the compiled key actions is typed from the keystring
+  cmd("AT BM 1");
+  cmd("AT KW abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz");
+  clearOut();
+  pressPin(2);
+  printf("long: %d bytes\n", hidlen);
+  return 0;
+}
@@ -0,0 +1,43 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: key_compile.cpp - test: compiled key actions of the buttons (keys.cpp)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "keys.h"
+
+extern uint8_t keyActionCount[];
+extern uint8_t keyActionStart[];
+
+int main()
+{
+  pinsHigh();
+  setup();
+  runFor(20);
+  cmd("AT BM 1"); cmd("AT KW Hi @x KEY_ENTER y KEY_FOO z");
+  cmd("AT BM 2"); cmd("AT KP KEY_CTRL  KEY_C ");
+  cmd("AT BM 3"); cmd("AT KW abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz");
+  cmd("AT BM 4"); cmd("AT KH KEY_SHIFT");
+  // key names which are longer than the name buffer are skipped as unknown keys
+  cmd("AT BM 5"); cmd("AT KW a KEY_ENTERKEY_ENTERKEY_ENTERKEY_ENTER b");
+  cmd("AT BM 6"); cmd("AT KP KEY_CTRLKEY_CTRLKEY_CTRLKEY_CTRLKEY_CTRL KEY_A");
+  for (int i = 0; i < 7; i++) printf("%d:%d@%d ", i, keyActionCount[i], keyActionStart[i]);
+  printf("\n");
+
+  char text[] = "a KEY_ENTERKEY_ENTERKEY_ENTERKEY_ENTER b";
+  char keys[] = "KEY_CTRLKEY_CTRLKEY_CTRLKEY_CTRLKEY_CTRL KEY_A";
+  clearOut();
+  sendToKeyboard(text);
+  pressSingleKeys(keys);
+  releaseSingleKeys(keys);
+  printf("%s\n", hidlog);
+  return 0;
+}
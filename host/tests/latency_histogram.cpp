@@ -0,0 +1,29 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: latency_histogram.cpp - test: switch-to-HID latency histograms (AT LH, build with LATENCY_HISTOGRAM)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+int main()
+{
+  pinsHigh();
+  setup();
+  clearOut();
+  for (int i = 0; i < 5; i++) pressPin(2);
+  pressPin(4);
+  cmd("AT LH");
+  printOut();
+  printf("\n");
+  cmd("AT LH");
+  printOut();
+  return 0;
+}
@@ -0,0 +1,32 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: loop_profile.cpp - test: main loop profile report (AT PR, build with LOOP_PROFILER)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+int main()
+{
+  pinsHigh();
+  setup();
+  clearOut();
+  runFor(200);
+  cmd("AT LI");
+  pressPin(2);
+  clearOut();
+  cmd("AT PR");
+  printOut();
+  printf("\n");
+  runFor(50);
+  cmd("AT PR");
+  printOut();
+  return 0;
+}
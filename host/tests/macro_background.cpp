@@ -0,0 +1,41 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: macro_background.cpp - test: macros run in the background, other buttons work meanwhile
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+int main()
+{
+  pinsHigh();
+  setup();
+  clearOut();
+  cmd("AT AP 1");
+  cmd("AT BM 2"); cmd("AT KP KEY_B");
+  cmd("AT BM 1"); cmd("AT MA KP KEY_A;WA 300;KW x\\;y;KP KEY_C");
+  clearOut();
+
+  // pin 2 = button 1 (INT1), pin 3 = button 2 (INT0)
+  mockPinChange(2, 0); runFor(30);
+  mockPinChange(2, 1); runFor(50);
+  printf("t=%u %s\n", millis(), hidlog);
+
+  // retrigger while the macro waits, and another button during the wait
+  mockPinChange(2, 0); runFor(30);
+  mockPinChange(2, 1);
+  mockPinChange(3, 0); runFor(30);
+  mockPinChange(3, 1);
+  printf("t=%u %s\n", millis(), hidlog);
+  runFor(400);
+  printf("t=%u %s\n", millis(), hidlog);
+  printOut();
+  return 0;
+}
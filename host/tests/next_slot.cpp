@@ -0,0 +1,39 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: next_slot.cpp - test: slot numbers when switching to the next slot (AT NE)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+extern uint8_t actSlot;
+
+int main()
+{
+  pinsHigh();
+  setup();
+  runFor(20);
+  cmd("AT SA one");
+  cmd("AT SA two");
+  cmd("AT SA three");
+  for (int i = 0; i < 6; i++) {
+    cmd("AT NE");
+    printf("%d ", actSlot);
+  }
+  cmd("AT LO two");
+  cmd("AT DE one");
+  for (int i = 0; i < 4; i++) {
+    cmd("AT NE");
+    printf("%d ", actSlot);
+  }
+  cmd("AT LA");
+  printf("after LA %d\n", actSlot);
+  return 0;
+}
@@ -0,0 +1,46 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: pin_snapshot.cpp - test: the port snapshot of the switch inputs equals digitalRead() of every pin, for both pin maps
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+
+extern int8_t input_map[];
+extern uint8_t NUMBER_OF_PHYSICAL_BUTTONS;
+
+/**
+   sets the switch inputs to random states, compares readButtonPins() with digitalRead() of every pin
+*/
+static int compareSnapshots(int rounds)
+{
+  int mismatches = 0;
+  srand(1);
+  for (int r = 0; r < rounds; r++) {
+    for (int pin = 0; pin < 24; pin++) mockSetPin(pin, rand() & 1);
+    uint16_t expected = 0;
+    for (uint8_t i = 0; i < NUMBER_OF_PHYSICAL_BUTTONS; i++)
+      if (digitalRead(input_map[i]) == LOW) expected |= (1 << i);
+    if (readButtonPins() != expected) mismatches++;
+  }
+  return mismatches;
+}
+
+int main()
+{
+  pinsHigh();
+  setup();
+  printf("no-PCB pin map: %d switches, %d mismatches in 1000 rounds\n", NUMBER_OF_PHYSICAL_BUTTONS, compareSnapshots(1000));
+  PCBversion = 1;
+  initButtons();
+  printf("PCB pin map: %d switches, %d mismatches in 1000 rounds\n", NUMBER_OF_PHYSICAL_BUTTONS, compareSnapshots(1000));
+  return 0;
+}
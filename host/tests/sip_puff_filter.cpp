@@ -0,0 +1,80 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: sip_puff_filter.cpp - test: pressure baseline tracking and sip/puff thresholds with hysteresis
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+extern uint16_t pressure;
+
+int main()
+{
+  pinsHigh();
+  mock_analog = 520;
+  setup();
+  clearOut();
+  printf("start p=%u\n", pressure);
+  cmd("AT TS 400");
+  cmd("AT TP 600");
+  cmd("AT BM 10");
+  cmd("AT KP KEY_A");
+  cmd("AT BM 11");
+  cmd("AT KP KEY_Z");
+  printOut();
+  printf("\n");
+  clearOut();
+
+  // a slow drift of the sensor must not trigger a puff
+  for (int v = 520; v <= 580; v++) {
+    mock_analog = v;
+    runFor(100);
+  }
+  printf("drift p=%u HID:%s\n", pressure, hidlog);
+  clearOut();
+
+  // puff above the threshold, then back into the hysteresis band: still pressed
+  mock_analog = 680; runFor(100); printf("puff p=%u %s\n", pressure, hidlog);
+  mock_analog = 660; runFor(200); printf("hyst p=%u %s\n", pressure, hidlog);
+  mock_analog = 640; runFor(200); printf("rel p=%u %s\n", pressure, hidlog);
+  clearOut();
+  mock_analog = 470; runFor(200); printf("sip p=%u %s\n", pressure, hidlog);
+  mock_analog = 580; runFor(200);
+  cmd("AT CA");
+  printf("%s p=%u\n", Serial.out, pressure);
+  clearOut();
+
+  // a hysteresis larger than the threshold: the puff is released at half the threshold
+  cmd("AT SH 200");
+  cmd("AT BM 11");
+  cmd("AT KH KEY_Z");
+  clearOut();
+  mock_analog = 690; runFor(200); printf("hold p=%u %s\n", pressure, hidlog);
+  mock_analog = 640; runFor(200); printf("above half p=%u %s\n", pressure, hidlog);
+  mock_analog = 580; runFor(200); printf("rest p=%u %s\n", pressure, hidlog);
+
+  // a short soft sip with a strong threshold: it ends before the decision,
+  // the soft action follows
+  cmd("AT SS 250");
+  clearOut();
+  mock_analog = 440; runFor(50); printf("short sip p=%u %s\n", pressure, hidlog);
+  mock_analog = 580; runFor(200); printf("short sip rest p=%u %s\n", pressure, hidlog);
+  cmd("AT SS 0");
+
+  // the baseline follows a small offset at the tick rate, also while a slot change
+  // waits for a held switch (RELEASE_ALL_TIMEOUT)
+  cmd("AT CA");
+  mock_analog = 620; runFor(2500); printf("idle 2.5s p=%u\n", pressure);
+  mock_analog = 580; runFor(20); cmd("AT CA");
+  mock_analog = 620; runFor(20);
+  mockSetPin(2, 0); cmd("AT NE"); mockSetPin(2, 1);
+  printf("slot change p=%u\n", pressure);
+  return 0;
+}
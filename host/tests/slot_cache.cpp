@@ -0,0 +1,64 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: slot_cache.cpp - test: slot changes (AT NE) load the same slots with and without SLOT_CACHE
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+
+extern uint8_t actSlot;
+
+/**
+   prints the active slot and a hash of its settings, button functions and keystrings
+*/
+static void printSlot()
+{
+  uint32_t h = 0;
+  const uint8_t * p = (const uint8_t *) &settings;
+  for (unsigned i = 0; i < sizeof(settings); i++) h = h * 31 + p[i];
+  for (int i = 0; i < NUMBER_OF_BUTTONS; i++) {
+    h = h * 31 + buttons[i].mode;
+    h = h * 31 + buttons[i].value;
+    for (const char * c = getKeystring(i); *c; c++) h = h * 31 + *c;
+    h = h * 31;
+  }
+  printf("slot %d %s %08x\n", actSlot, settings.slotname, h);
+}
+
+int main()
+{
+  pinsHigh();
+  setup();
+  runFor(20);
+  cmd("AT BM 1"); cmd("AT KW hello"); cmd("AT TS 200"); cmd("AT SA one");
+  cmd("AT BM 2"); cmd("AT KW a very long keystring that does not fit into the slot cache at all, it has more than ninety-six characters");
+  cmd("AT SA two");
+  cmd("AT BM 3"); cmd("AT KP KEY_A"); cmd("AT MX -7"); cmd("AT SA three");
+  for (int i = 0; i < 8; i++) {
+    cmd("AT NE");
+    printSlot();
+  }
+
+  // overwrite the slot which is decoded in advance
+  cmd("AT LO one"); cmd("AT BM 4"); cmd("AT KW changed"); cmd("AT SA three");
+  for (int i = 0; i < 4; i++) {
+    cmd("AT NE");
+    printSlot();
+  }
+
+  // delete a slot: the following slot moves up in the slot directory
+  cmd("AT DE two");
+  for (int i = 0; i < 4; i++) {
+    cmd("AT NE");
+    printSlot();
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: slots.cpp - test: saving, loading, listing and deleting slots, reboot
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+
+int main()
+{
+  pinsHigh();
+  setup();
+  runFor(20);
+  clearOut();
+  cmd("AT BM 1"); cmd("AT KW hello"); cmd("AT SA one");
+  cmd("AT BM 2"); cmd("AT KP KEY_A KEY_B"); cmd("AT SA two");
+  cmd("AT BM 1"); cmd("AT KW a much longer text for slot three"); cmd("AT SA three");
+  cmd("AT LI");
+  cmd("AT FR");
+  for (int i = 0; i < 5; i++) {
+    cmd("AT NE");
+    cmd("AT ID");
+  }
+  cmd("AT LO two"); cmd("AT BM 3"); cmd("AT KW grown string in two"); cmd("AT SA two");
+  cmd("AT LO three");
+  cmd("AT LO one");
+  cmd("AT LO nope");
+  cmd("AT DE one");
+  cmd("AT LI");
+  cmd("AT NE"); cmd("AT NE"); cmd("AT NE");
+  cmd("AT LA");
+  cmd("AT FR");
+  cmd("AT ED");
+  printOut();
+
+  // reboot
+  setup();
+  runFor(20);
+  cmd("AT LI");
+  cmd("AT LA");
+  cmd("AT RS");
+  cmd("AT LI");
+  cmd("AT FR");
+  printOut();
+
+  // command identifiers from 63 on are stored with an extra byte (200 is beyond NUM_COMMANDS, only for the test)
+  buttons[0].mode = 62;
+  buttons[1].mode = 63;
+  buttons[2].mode = 200;
+  buttons[2].value = -5;
+  cmd("AT SA escape");
+  buttons[0].mode = buttons[1].mode = buttons[2].mode = CMD_HL;
+  cmd("AT LO escape");
+  printf("modes %d %d %d value %d\n", buttons[0].mode, buttons[1].mode, buttons[2].mode, buttons[2].value);
+  clearOut();
+  return 0;
+}
@@ -0,0 +1,63 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: storage_file.cpp - test: slots in a file (build with STORAGE_FILE), the test restarts itself to reload them
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include "eepromStorage.h"
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+extern uint8_t numSlots;
+
+int main(int argc, char ** argv)
+{
+  uint8_t reload = (argc > 2) && (!strcmp(argv[1], "reload"));
+  int saved = reload ? atoi(argv[2]) : 0;
+  if (!reload) unlink(STORAGE_FILE);
+
+  pinsHigh();
+  setup();
+  runFor(20);
+  printf("boot: numSlots=%d size=%lu\n", numSlots, (unsigned long) STORAGE_SIZE);
+  if (!reload) {
+    for (int i = 0; i < 30; i++) {
+      char line[40], name[20];
+      snprintf(line, sizeof(line), "AT KW file text %d", i);
+      cmd("AT BM 1");
+      cmd(line);
+      snprintf(name, sizeof(name), "f%d", i);
+      if (!saveToEEPROM(name)) break;
+      saved++;
+    }
+    printf("saved %d slots: numSlots=%d free=%d%%\n", saved, numSlots, getfreeEEPROM());
+    storageFlush();
+    fflush(stdout);
+    char count[8];
+    snprintf(count, sizeof(count), "%d", saved);
+    execl(argv[0], argv[0], "reload", count, (char *) 0);
+    perror(argv[0]);
+    return 1;
+  }
+
+  int bad = 0;
+  for (int i = 0; i < saved; i++) {
+    char line[30], text[30];
+    snprintf(line, sizeof(line), "AT LO f%d", i);
+    snprintf(text, sizeof(text), "file text %d", i);
+    cmd(line);
+    if (strcmp(getKeystring(0), text)) bad++;
+  }
+  printf("reload %d slots from file: bad=%d\n", saved, bad);
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: storage_i2c.cpp - test: slot log on an emulated 24LCxx I2C EEPROM (build with STORAGE_I2C_EEPROM)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include "eepromStorage.h"
+#include "Wire.h"
+#include <string.h>
+
+#define SLOTS 60
+
+extern uint8_t numSlots, pageLen, readLen;
+
+static char texts[SLOTS][40];
+static uint8_t snapshot[STORAGE_SIZE];
+
+/**
+   restarts the firmware; the buffers of the I2C backend are lost like at a power loss
+*/
+static void reboot()
+{
+  pageLen = readLen = 0;
+  setup();
+  runFor(5);
+  clearOut();
+}
+
+static void editSlot(const char * name, const char * text)
+{
+  char line[60];
+  snprintf(line, sizeof(line), "AT LO %s", name);
+  cmd(line);
+  cmd("AT BM 1");
+  snprintf(line, sizeof(line), "AT KW %s", text);
+  cmd(line);
+}
+
+int main()
+{
+  MockI2CEeprom & chip = I2CEEPROM;
+  chip.size = STORAGE_SIZE;
+  chip.page = I2C_EEPROM_PAGE_SIZE;
+  chip.addrBytes = I2C_EEPROM_ADDRESS_BYTES;
+  pinsHigh();
+  setup();
+  runFor(20);
+
+  // fill the EEPROM (up to MAX_SLOTS)
+  unsigned long pageWrites = chip.pageWrites, bytes = chip.bytesWritten;
+  int n = 0;
+  for (int i = 0; i < SLOTS; i++) {
+    char line[60], name[20];
+    snprintf(texts[i], sizeof(texts[i]), "text number %d for button one", i);
+    cmd("AT BM 1");
+    snprintf(line, sizeof(line), "AT KW %.40s", texts[i]);
+    cmd(line);
+    cmd("AT BM 2");
+    cmd(i & 1 ? "AT KP KEY_A" : "AT KH KEY_B");
+    snprintf(name, sizeof(name), "s%d", i);
+    if (!saveToEEPROM(name)) break;
+    n++;
+  }
+  printf("%lu bytes: saved %d slots, numSlots=%d, page writes per save=%.1f, bytes per save=%.1f\n",
+         (unsigned long) chip.size, n, numSlots, (chip.pageWrites - pageWrites) / (double) n,
+         (chip.bytesWritten - bytes) / (double) n);
+  storageFlush();
+
+  reboot();
+  uint32_t start = mock_micros;
+  unsigned long transfers = chip.transfers;
+  bootstrapEEPROM();
+  printf("boot scan: %lu transfers, %.1f ms at 400 kHz\n", chip.transfers - transfers, (mock_micros - start) / 1000.0);
+  int bad = 0;
+  for (int i = 0; i < n; i++) {
+    char line[20];
+    snprintf(line, sizeof(line), "AT LO s%d", i);
+    cmd(line);
+    if (strcmp(getKeystring(0), texts[i])) bad++;
+  }
+  printf("reload after reboot: bad=%d free=%d%%\n", bad, getfreeEEPROM());
+
+  // wear: 3000 edits of one slot
+  memset(chip.wear, 0, sizeof(chip.wear));
+  pageWrites = chip.pageWrites;
+  for (int i = 0; i < 3000; i++) {
+    char text[20];
+    snprintf(text, sizeof(text), "e%d", i);
+    editSlot("s1", text);
+    saveToEEPROM("s1");
+  }
+  unsigned long maxWear = 0;
+  for (unsigned i = 0; i < chip.size; i++)
+    if (chip.wear[i] > maxWear) maxWear = chip.wear[i];
+  printf("3000 edits: %.1f page writes per save, max wear of a byte %lu\n", (chip.pageWrites - pageWrites) / 3000.0, maxWear);
+
+  // power loss: saves are interrupted after k page writes
+  storageFlush();
+  memcpy(snapshot, chip.mem, STORAGE_SIZE);
+  int olds = 0, news = 0;
+  bad = 0;
+  for (int round = 0; round < 20; round++) {
+    for (int k = 0; k < 12; k++) {
+      memcpy(chip.mem, snapshot, STORAGE_SIZE);
+      reboot();
+      editSlot("s3", "crash text");
+      chip.writeLimit = k;
+      saveToEEPROM("s3");
+      storageFlush();
+      chip.writeLimit = -1;
+      reboot();
+      cmd("AT LO s3");
+      if (!strcmp(getKeystring(0), "crash text")) news++;
+      else if (!strcmp(getKeystring(0), texts[3])) olds++;
+      else {
+        bad++;
+        printf("s3 k=%d round=%d [%s]\n", k, round, getKeystring(0));
+      }
+      cmd("AT LO s4");
+      if (strcmp(getKeystring(0), texts[4])) {
+        bad++;
+        printf("s4 k=%d round=%d [%s]\n", k, round, getKeystring(0));
+      }
+    }
+    memcpy(chip.mem, snapshot, STORAGE_SIZE);
+    reboot();
+    for (int j = 0; j < 10; j++) {
+      char text[20];
+      snprintf(text, sizeof(text), "r%d %d", round, j);
+      editSlot("s1", text);
+      saveToEEPROM("s1");
+    }
+    storageFlush();
+    memcpy(snapshot, chip.mem, STORAGE_SIZE);
+  }
+  printf("crash tests: old=%d new=%d bad=%d\n", olds, news, bad);
+  return 0;
+}
@@ -0,0 +1,42 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: strong_sip_puff.cpp - test: strong puff detection (AT SP) next to the normal puff
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+int main()
+{
+  pinsHigh();
+  mock_analog = 512;
+  setup();
+  clearOut();
+  cmd("AT TP 600");
+  cmd("AT SP 700");
+  cmd("AT BM 11");
+  cmd("AT KP KEY_A");
+  cmd("AT BM 13");
+  cmd("AT KP KEY_Z");
+  clearOut();
+
+  mock_analog = 650; runFor(300); mock_analog = 512; runFor(300);
+  printf("soft: %s\n", hidlog);
+  clearOut();
+  mock_analog = 800; runFor(300); mock_analog = 512; runFor(300);
+  printf("strong: %s\n", hidlog);
+  clearOut();
+
+  cmd("AT SP 1023");
+  clearOut();
+  mock_analog = 800; runFor(300); mock_analog = 512; runFor(300);
+  printf("nostrong: %s\n", hidlog);
+  return 0;
+}
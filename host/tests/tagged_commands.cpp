@@ -0,0 +1,45 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: tagged_commands.cpp - test: tagged AT commands ("AT#<tag> ...") and their responses
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+int main()
+{
+  pinsHigh();
+  setup();
+  runFor(300);                      // the default slot is written in the background
+  clearOut();
+  cmd("AT#1 ID");
+  cmd("AT#2 LI");
+  cmd("AT#3 CL");
+  cmd("AT#4");
+  cmd("AT#5 XX");
+  cmd("AT ID");
+  cmd("AT#abcdef ID");
+  cmd("AT#7 LA");
+  printOut();
+
+  // a tagged macro is answered when it has finished, a replaced macro when it is replaced
+  cmd("AT#8 MA KP KEY_A;WA 100;KP KEY_B");
+  printf("t=%u started: %s\n", millis(), Serial.out);
+  clearOut();
+  runFor(150);
+  printf("t=%u finished: %s", millis(), Serial.out);
+  clearOut();
+  cmd("AT#9 MA WA 500;KP KEY_C");
+  cmd("AT#10 MA KP KEY_D");
+  runFor(50);
+  printf("t=%u replaced: %s", millis(), Serial.out);
+  printf("%s\n", hidlog);
+  return 0;
+}
@@ -0,0 +1,52 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: telemetry.cpp - test: binary telemetry stream (AT SB) and burst capture (AT BU)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+
+/**
+   prints the output: binary frames as "op <opcode> len <n>: <payload>", text as it is
+*/
+static void printStream(const char * buf, int n)
+{
+  int i = 0;
+  while (i < n) {
+    if ((uint8_t) buf[i] == 0xFB) {
+      int len = (uint8_t) buf[i + 1], op = (uint8_t) buf[i + 2];
+      printf("op %02x len %d:", op, len);
+      for (int k = 0; k < len; k++) printf(" %02x", (uint8_t) buf[i + 3 + k]);
+      printf("\n");
+      i += len + 5;
+    }
+    else putchar(buf[i++]);
+  }
+}
+
+int main()
+{
+  pinsHigh();
+  setup();
+  runFor(50);
+  clearOut();
+  cmd("AT SB 2");
+  mock_analog = 600; runFor(30);
+  mock_analog = 512; runFor(10);
+  cmd("AT ER");
+  printStream(Serial.out, Serial.outLen);
+  clearOut();
+  runFor(20);
+  printf("after ER len=%d\n", Serial.outLen);
+  cmd("AT BU 10");
+  runFor(200);
+  printStream(Serial.out, Serial.outLen);
+  return 0;
+}
@@ -0,0 +1,70 @@
+/*
+     Flexible Assistive Button Interface (FABI) - AsTeRICS Foundation - http://www.asterics-foundation.org
+     for controlling HID functions via momentary switches and/or serial AT-commands
+     More Information: https://github.com/asterics/FABI
+
+     Module: tx_queue.cpp - test: host transmit queue under back-pressure (hostSerial.cpp)
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License, see:
+     http://www.gnu.org/licenses/gpl-3.0.en.html
+
+*/
+
+#include "harness.h"
+#include "fabi.h"
+#include <string.h>
+
+int main()
+{
+  pinsHigh();
+  setup();
+  runFor(50);
+  clearOut();
+  cmd("AT SR");
+  runFor(200);
+  printf("free-flow VALUES lines: %d\n", (int) (strstr(Serial.out, "VALUES") != 0));
+
+  // blocked USB endpoint: nothing is sent
+  Serial.txSpace = 0;
+  clearOut();
+  runFor(1000);
+  printf("blocked out len=%d\n", Serial.outLen);
+
+  // unblocked: only complete lines arrive
+  Serial.txSpace = 1000000;
+  runFor(10);
+  int complete = 1;
+  char * p = Serial.out;
+  while ((p = strstr(p, "VALUES:"))) {
+    char * end = strchr(p, '\n');
+    if ((!end) || (end - p > 40)) complete = 0;
+    p += 7;
+  }
+  printf("after unblock len=%d lines ok=%d\n", Serial.outLen, complete);
+
+  cmd("AT ER");
+  runFor(50);
+  clearOut();
+  cmd("AT TQ");
+  printOut();
+  Serial.txSpace = 0;
+  cmd("AT LI");
+  printf("response while blocked: ");
+  printOut();
+  Serial.txSpace = 1000000;
+  cmd("AT TQ");
+  printOut();
+
+  // a telemetry output which is longer than the whole queue is dropped completely
+  runFor(10);
+  clearOut();
+  hostSerial.beginTelemetry();
+  for (int i = 0; i < TX_QUEUE_LEN + 10; i++) hostSerial.write('x');
+  printf("long telemetry dropped=%d\n", hostSerial.endTelemetry());
+  runFor(10);
+  printf("sent x: %d\n", (int) (strchr(Serial.out, 'x') != 0));
+  cmd("AT TQ");
+  printOut();
+  return 0;
+}